@@ -42,6 +42,56 @@ namespace lsp
             static constexpr float PREDELAY_DFL             = 0.0f;     // Pre-delay length (ms)
             static constexpr float PREDELAY_STEP            = 0.01f;    // Pre-delay step (ms)
 
+            static constexpr float XFADE_MIN                = 0.0f;     // Minimum convolver crossfade time (ms)
+            static constexpr float XFADE_MAX                = 50.0f;    // Maximum convolver crossfade time (ms)
+            static constexpr float XFADE_DFL                = 10.0f;    // Convolver crossfade time (ms)
+            static constexpr float XFADE_STEP               = 0.01f;    // Convolver crossfade step (ms)
+
+            static constexpr float BANK_MEM_MIN             = 16.0f;    // Minimum IR bank memory budget (MB)
+            static constexpr float BANK_MEM_MAX             = 4096.0f;  // Maximum IR bank memory budget (MB)
+            static constexpr float BANK_MEM_DFL             = 512.0f;   // IR bank memory budget (MB)
+            static constexpr float BANK_MEM_STEP            = 1.0f;     // IR bank memory budget step (MB)
+
+            static constexpr float RECONF_MEM_MIN           = 64.0f;    // Minimum reconfiguration memory budget (MB)
+            static constexpr float RECONF_MEM_MAX           = 65536.0f; // Maximum reconfiguration memory budget (MB)
+            static constexpr float RECONF_MEM_DFL           = 8192.0f;  // Reconfiguration memory budget (MB)
+            static constexpr float RECONF_MEM_STEP          = 1.0f;     // Reconfiguration memory budget step (MB)
+
+            static constexpr size_t WORKERS_MIN             = 0;        // Minimum number of worker threads, 0 means host executor
+            static constexpr size_t WORKERS_MAX             = 16;       // Maximum number of worker threads
+            static constexpr size_t WORKERS_DFL             = 0;        // Number of worker threads
+            static constexpr size_t WORKERS_STEP            = 1;        // Number of worker threads step
+
+            static constexpr float MORPH_MIN                = 0.0f;     // Minimum IR morphing amount (%)
+            static constexpr float MORPH_MAX                = 100.0f;   // Maximum IR morphing amount (%)
+            static constexpr float MORPH_DFL                = 0.0f;     // IR morphing amount (%)
+            static constexpr float MORPH_STEP               = 0.1f;     // IR morphing step (%)
+
+            static constexpr float CPU_LOAD_MIN             = 0.0f;     // Minimum CPU load (%)
+            static constexpr float CPU_LOAD_MAX             = 100.0f;   // Maximum CPU load (%)
+            static constexpr float CPU_LOAD_DFL             = 0.0f;     // CPU load (%)
+            static constexpr float CPU_LOAD_STEP            = 0.1f;     // CPU load step (%)
+
+            static constexpr float DEADLINE_MIN             = 10.0f;    // Minimum deadline, fraction of the block duration (%)
+            static constexpr float DEADLINE_MAX             = 100.0f;   // Maximum deadline, fraction of the block duration (%)
+            static constexpr float DEADLINE_DFL             = 80.0f;    // Deadline, fraction of the block duration (%)
+            static constexpr float DEADLINE_STEP            = 0.1f;     // Deadline step (%)
+
+            static constexpr float MISSES_MIN               = 0.0f;     // Minimum number of deadline misses
+            static constexpr float MISSES_MAX               = 1e+9f;    // Maximum number of deadline misses
+            static constexpr float MISSES_DFL               = 0.0f;     // Number of deadline misses
+            static constexpr float MISSES_STEP              = 1.0f;     // Number of deadline misses step
+
+            static constexpr float RECONFIG_MIN             = 0.0f;     // Minimum reconfiguration latency (ms)
+            static constexpr float RECONFIG_MAX             = 600000.0f;// Maximum reconfiguration latency (ms)
+            static constexpr float RECONFIG_DFL             = 0.0f;     // Reconfiguration latency (ms)
+            static constexpr float RECONFIG_STEP            = 0.01f;    // Reconfiguration latency step (ms)
+
+            static constexpr float MEMORY_MIN               = 0.0f;     // Minimum memory usage (MB)
+            static constexpr float MEMORY_MAX               = 65536.0f; // Maximum memory usage (MB)
+            static constexpr float MEMORY_DFL               = 0.0f;     // Memory usage (MB)
+            static constexpr float MEMORY_STEP              = 0.01f;    // Memory usage step (MB)
+
             static constexpr size_t MESH_SIZE               = 600;      // Maximum mesh size
             static constexpr size_t TRACKS_MAX              = 8;        // Maximum tracks per mesh/sample
 
@@ -32,6 +32,9 @@
 #include <lsp-plug.in/dsp-units/util/Delay.h>
 
 #include <private/meta/impulse_reverb.h>
+#include <private/plugins/perf.h>
+#include <private/plugins/sample_pool.h>
+#include <private/plugins/worker_pool.h>
 
 namespace lsp
 {
@@ -45,6 +48,28 @@ namespace lsp
             protected:
                 struct af_descriptor_t;
 
+                enum stage_t
+                {
+                    STG_CONVOLUTION,    // Convolution and mixing of convolver outputs
+                    STG_EQUALIZER,      // Wet signal equalization
+                    STG_PLAYER,         // Dry signal mixing and sample preview
+                    STG_BYPASS,         // Bypass switch
+                    STG_SWAP,           // Configuration task management and data swap
+                    STG_PROCESS,        // Whole process() call
+
+                    STG_TOTAL
+                };
+
+                enum miss_cause_t
+                {
+                    MISS_CONVOLUTION,   // Convolution took the most time of the late block
+                    MISS_EQUALIZER,     // Equalization took the most time of the late block
+                    MISS_SWAP,          // Data swap took the most time of the late block
+                    MISS_OTHER,         // Other processing took the most time of the late block
+
+                    MISS_TOTAL
+                };
+
                 class IRLoader: public ipc::ITask
                 {
                     private:
@@ -95,18 +120,87 @@ namespace lsp
                         void        dump(dspu::IStateDumper *v) const;
                 };
 
+                class ConvolverTask: public ipc::ITask
+                {
+                    private:
+                        impulse_reverb     *pCore;
+
+                    public:
+                        inline ConvolverTask()
+                        {
+                            pCore       = NULL;
+                        }
+
+                        void init(impulse_reverb *base);
+                        virtual ~ConvolverTask() override;
+
+                    public:
+                        virtual status_t    run() override;
+                        void                dump(dspu::IStateDumper *v) const;
+                };
+
+                class ExecutorTask: public ipc::ITask
+                {
+                    private:
+                        impulse_reverb     *pCore;
+
+                    public:
+                        explicit ExecutorTask(impulse_reverb *base);
+                        virtual ~ExecutorTask() override;
+
+                    public:
+                        virtual status_t run() override;
+
+                        void        dump(dspu::IStateDumper *v) const;
+                };
+
+                typedef struct peaks_t
+                {
+                    float              *vData;          // Peak pyramid of all tracks, the finest level goes first
+                    uint8_t            *pData;          // Allocated data
+                    size_t              nChannels;      // Number of tracks
+                    size_t              nLength;        // Length of the analyzed sample
+                    size_t              nBlocks;        // Number of blocks at the finest level
+                    size_t              nStride;        // Number of values per track for all levels
+                    size_t              nSource;        // Generation of the source data
+                    size_t              nHeadCut;       // Head cut of the analyzed sample
+                    size_t              nTailCut;       // Tail cut of the analyzed sample
+                    size_t              nFadeIn;        // Fade-in of the analyzed sample
+                    size_t              nFadeOut;       // Fade-out of the analyzed sample
+                    bool                bReverse;       // Reverse flag of the analyzed sample
+                } peaks_t;
+
                 typedef struct af_descriptor_t
                 {
                     dspu::Toggle        sListen;        // Listen toggle
                     dspu::Toggle        sStop;          // Stop toggle
                     dspu::Sample       *pOriginal;      // Original audio file
                     dspu::Sample       *pProcessed;     // Processed audio file for sampler
+                    dspu::Sample       *pRendered;      // Rendered audio file kept in memory-lean mode
+                    dspu::Sample       *pResampled;     // Cached cut and resampled original audio file
                     float              *vThumbs[meta::impulse_reverb_metadata::TRACKS_MAX];           // Thumbnails
                     float               fNorm;          // Norming factor
                     status_t            nStatus;
+                    size_t              nChannels;      // Number of channels in rendered file
+                    size_t              nTracks;        // Mask of tracks referenced by convolvers
+                    size_t              nLoadMask;      // Mask of tracks requested at last load, except tracks missing in the embedded data
+                    size_t              nEmbedMask;     // Mask of tracks which do not need to be stored in the embedded data again
+                    size_t              nEmbedFirst;    // First original sample stored in the embedded data
+                    size_t              nEmbedLast;     // Original sample after the last one stored in the embedded data
+                    size_t              nResampleRate;  // Sample rate of the cached resampled file
+                    size_t              nResampleHead;  // Head cut of the cached resampled file, original samples
+                    size_t              nResampleTail;  // Tail cut of the cached resampled file, original samples
+                    size_t              nSourceGen;     // Generation of the source data, changes on load and resample
+                    peaks_t             sPeaks;         // Peak pyramid for thumbnails
+                    perf::timing_t      sLoadTime;      // Timing of the file loading
+                    size_t              nMemory;        // Memory held by the file data except the preview sample, bytes
+                    size_t              nPlayMem;       // Memory held by the preview sample bound to players, bytes
                     bool                bRender;        // Flag that indicates that file needs rendering
                     bool                bSync;          // Synchronize file
                     bool                bReverse;
+                    bool                bPreview;       // Preview sample has been requested in memory-lean mode
+                    bool                bPreviewDone;   // Preview sample request has been processed by configurator
+                    bool                bReload;        // File needs to be re-loaded with more tracks
 
                     float               fPitch;         // Pitch amount
                     float               fHeadCut;
@@ -129,21 +223,55 @@ namespace lsp
                     plug::IPort        *pStatus;        // Status of file loading
                     plug::IPort        *pLength;        // Length of file
                     plug::IPort        *pThumbs;        // Thumbnails of file
+                    plug::IPort        *pMemory;        // Memory usage
                 } af_descriptor_t;
 
+                typedef struct xfade_t
+                {
+                    dspu::Convolver    *pOld;           // Convolver that is being faded out, not owned
+                    size_t              nPos;           // Current crossfade position
+                    size_t              nLen;           // Crossfade length, zero if there is no active crossfade
+                } xfade_t;
+
                 typedef struct convolver_t
                 {
                     dspu::Delay         sDelay;         // Delay line
 
                     dspu::Convolver    *pCurr;          // Currently used convolver
                     dspu::Convolver    *pSwap;          // Swap
-
-                    size_t              nFile;          // File
+                    dspu::Convolver    *vBank[meta::impulse_reverb_metadata::FILES];        // Prepared IR bank
+                    dspu::Convolver    *vBankSwap[meta::impulse_reverb_metadata::FILES];    // Swap for prepared IR bank
+
+                    size_t              nCurrMem;       // Memory held by the current convolver, bytes
+                    size_t              nSwapMem;       // Memory held by the swap convolver, bytes
+                    size_t              vBankMem[meta::impulse_reverb_metadata::FILES];     // Memory held by IR bank entries, bytes
+                    size_t              vBankSwapMem[meta::impulse_reverb_metadata::FILES]; // Memory held by swap IR bank entries, bytes
+
+                    bool                bDefer;         // Creation is deferred until the old convolver is released
+                    bool                bKeep;          // Keep the current convolver on data swap
+                    bool                bRebuild;       // Only the rebuilt convolvers are replaced on data swap
+                    bool                bMute;          // Convolver is muted
+                    bool                bBank;          // IR bank mode of the active data
+                    bool                bBankSwap;      // IR bank mode of the swap data
+                    bool                bBankReq;       // IR bank mode requested by settings
+                    bool                bStale;         // The current convolver keeps the signal of its previous activation
+                    bool                vStale[meta::impulse_reverb_metadata::FILES];       // IR bank entries keeping the signal of previous activation
+
+                    xfade_t             sFade;          // Crossfade of the main convolver
+                    size_t              nBuildReq;      // Number of requests to rebuild convolvers of the channel only
+                    size_t              nBuildResp;     // Number of served requests to rebuild convolvers of the channel only
+                    size_t              nFile;          // File, selects the prepared IR bank entry in IR bank mode
                     size_t              nTrack;         // Track
+                    size_t              nMorphFile;     // Morph target file, zero if morphing is off
+                    float               fMorph;         // Morphing amount applied to the impulse response
+                    size_t              nMorphHold;     // Samples left until the morphing settles and the convolver is rebuilt
 
                     float              *vBuffer;        // Buffer for convolution
+                    float              *vTemp;          // Temporary buffer for crossfading
                     float               fPanIn[2];      // Input panning of convolver
                     float               fPanOut[2];     // Output panning of convolver
+                    float               fOldPanIn[2];   // Input panning applied at the end of the previous block
+                    float               fOldPanOut[2];  // Output panning applied at the end of the previous block
 
                     plug::IPort        *pMakeup;        // Makeup gain of convolver
                     plug::IPort        *pPanIn;         // Input panning of convolver
@@ -153,6 +281,10 @@ namespace lsp
                     plug::IPort        *pPredelay;      // Pre-delay
                     plug::IPort        *pMute;          // Mute button
                     plug::IPort        *pActivity;      // Activity indicator
+                    plug::IPort        *pBank;          // IR bank mode
+                    plug::IPort        *pMorphFile;     // Morph target file
+                    plug::IPort        *pMorph;         // Morphing amount
+                    plug::IPort        *pMemory;        // Memory usage
                 } convolver_t;
 
                 typedef struct channel_t
@@ -165,6 +297,13 @@ namespace lsp
                     float              *vOut;
                     float              *vBuffer;        // Rendering buffer
                     float               fDryPan[2];     // Dry panorama
+                    float               fOldDryPan[2];  // Dry panorama applied at the end of the previous block
+                    float               vEqGain[meta::impulse_reverb_metadata::EQ_BANDS];     // Applied gain of each equalizer band
+                    float               fLowFreq;       // Applied low-cut frequency
+                    float               fHighFreq;      // Applied high-cut frequency
+                    size_t              nLowSlope;      // Applied low-cut slope
+                    size_t              nHighSlope;     // Applied high-cut slope
+                    bool                bEqReset;       // Force update of all equalizer filters
 
                     plug::IPort        *pOut;
 
@@ -190,16 +329,74 @@ namespace lsp
                 static void             destroy_channel(channel_t *c);
                 static void             destroy_convolver(convolver_t *cv);
                 static size_t           get_fft_rank(size_t rank);
+                static size_t           convolver_size(size_t length, size_t rank);
+                static void             init_peaks(peaks_t *p);
+                static void             destroy_peaks(peaks_t *p);
+                static void             update_peak_blocks(peaks_t *p, dspu::Sample *s, size_t first, size_t last);
+                static size_t           sample_memory(const dspu::Sample *s);
+                static size_t           peaks_memory(const peaks_t *p);
+                static size_t           convolver_memory(const convolver_t *c);
+                static void             update_file_memory(af_descriptor_t *f);
+                static miss_cause_t     miss_cause(const perf::timing_t *stages);
+                static void             mark_stage(uint64_t *spent, size_t stage, uint64_t *ts);
+                static void             ramp_copy(float *dst, const float *src, float *k_old, float k_new, size_t count);
+                static void             ramp_add(float *dst, const float *src, float *k_old, float k_new, size_t count);
+                static dspu::Convolver *active_convolver(const convolver_t *c);
+                static void             mark_stale(convolver_t *c, const dspu::Convolver *cv);
+                static dspu::Sample    *rendered_sample(af_descriptor_t *af);
+                static ssize_t          track_index(const af_descriptor_t *af, size_t track);
+                static status_t         select_tracks(dspu::Sample * &af, size_t mask);
+                static status_t         load_prepared(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask);
+                static status_t         load_mapped(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask);
+                static status_t         load_stream(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask);
 
             protected:
                 bool                    has_active_loading_tasks();
+                size_t                  required_tracks(size_t file) const;
+                bool                    has_active_crossfades();
+                bool                    has_active_convolver_tasks();
+                bool                    has_build_requests();
+                bool                    has_morph_holds();
+                bool                    has_preview_requests();
+                bool                    has_pending_files();
+                void                    start_crossfade(xfade_t *xf, dspu::Convolver *old, dspu::Convolver *curr);
+                static void             process_crossfade(xfade_t *xf, dspu::Convolver *cv, float *dst, const float *src, float *temp, size_t samples);
+                static void             process_convolver(xfade_t *xf, dspu::Convolver *cv, float *dst, const float *src, float *temp, size_t samples);
+                status_t                init_convolver(dspu::Convolver **dst, size_t *mem, const float *data, size_t length, float phase);
+                status_t                create_convolver(dspu::Convolver **dst, size_t *mem, size_t file, size_t track, size_t target, float morph, float phase, size_t *budget);
                 status_t                load(af_descriptor_t *descr);
+                void                    make_kvt_key(char *dst, size_t len, const af_descriptor_t *descr, const char *name) const;
+                status_t                load_embedded(af_descriptor_t *descr, dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t *mask);
+                void                    embed_file(af_descriptor_t *descr, dspu::Sample *af, float peak, size_t channels, const char *fname, size_t mask);
+                void                    drop_embedded(af_descriptor_t *descr);
+                void                    source_cuts(const af_descriptor_t *f, size_t srate, size_t *head, size_t *tail) const;
+                void                    embed_range(const af_descriptor_t *f, size_t length, size_t srate, size_t *first, size_t *last) const;
+                bool                    embed_covers(const af_descriptor_t *f) const;
                 status_t                reconfigure();
+                status_t                reload_original(af_descriptor_t *f);
+                status_t                render_normal(af_descriptor_t *f);
+                status_t                render_lean(af_descriptor_t *f);
+                status_t                render_preview(af_descriptor_t *f);
+                status_t                update_peaks(af_descriptor_t *f, dspu::Sample *s, size_t head_cut, size_t tail_cut, size_t fade_in, size_t fade_out);
+                void                    render_thumbnails(af_descriptor_t *f, dspu::Sample *s);
+                status_t                resample_original(af_descriptor_t *f, dspu::Sample **src, size_t *head_cut, size_t *tail_cut);
+                status_t                render_file(af_descriptor_t *f, dspu::Sample **out);
+                size_t                  reconfig_memory() const;
+                bool                    reserve_memory();
+                void                    release_memory();
+                status_t                configure_executor();
+                void                    detach_executor();
+                void                    process_executor_tasks();
+                void                    process_restore_events(size_t samples);
+                void                    process_morph_events(size_t samples);
                 void                    process_loading_tasks();
                 void                    process_configuration_tasks();
                 void                    process_gc_events();
                 void                    process_listen_events();
                 void                    perform_convolution(size_t samples);
+                void                    process_convolvers(size_t samples);
+                void                    run_convolvers();
+                void                    convolve(convolver_t *c, size_t samples);
                 void                    output_parameters();
                 void                    perform_gc();
 
@@ -208,7 +405,38 @@ namespace lsp
                 size_t                  nReconfigReq;
                 size_t                  nReconfigResp;
                 size_t                  nRank;
+                size_t                  nBlockSize;     // Maximum number of samples processed at once
+                bool                    bOffline;       // Offline rendering mode
+                size_t                  nXFade;         // Convolver crossfade length in samples
+                size_t                  nBankMem;       // IR bank memory budget in bytes
+                size_t                  nReconfMem;     // Reconfiguration memory budget in bytes
+                atomic_t                nReserved;      // Memory reserved in the process-wide budget, kilobytes
+                volatile bool           bRestore;       // State has been restored
+                bool                    bRestoreBatch;  // Files of the restored state are being loaded
+                bool                    bRestoreConfig; // Configuration of the restored state is running
+                bool                    bRestoreCheck;  // Check that the restored state requested loading of files
+                size_t                  nRestoreHold;   // Samples left to wait for other files of the restored state
+                size_t                  nWorkers;       // Requested number of worker pool threads, zero for host executor
+                size_t                  nWorkerPrio;    // Requested priority of worker pool threads
+                size_t                  nPoolWorkers;   // Applied number of worker pool threads
+                size_t                  nPoolPrio;      // Applied priority of worker pool threads
+                bool                    bDeferPending;  // Deferred convolvers need to be created
+                bool                    bFlush;         // Convolvers should be rebuilt to drop the signal of the previous activation
+                bool                    bFlushPass;     // Running reconfiguration replaces convolvers without crossfade
+                bool                    bDeferPass;     // Running reconfiguration creates only deferred and requested convolvers and previews
+                bool                    bLean;          // Memory-lean mode
+                bool                    bEmbed;         // Embed impulse response data into the state
+                bool                    bSnapGains;     // Apply gains without ramping on the next settings update
+                float                   fCpuLoad;       // Smoothed CPU load, percent of the block duration
+                size_t                  nMemPeak;       // Peak memory usage observed at reconfiguration, bytes
+                float                   fDeadline;      // Deadline, fraction of the block duration
+                size_t                  nMisses;        // Number of blocks which missed the deadline
+                size_t                  vMissCause[MISS_TOTAL];     // Number of deadline misses per cause
+                uint64_t                nReqTime;       // Time of the pending reconfiguration request, zero if none
+                uint64_t                nSubmitTime;    // Time of the request served by the running reconfiguration
                 dspu::Sample           *pGCList;        // Garbage collection list
+                volatile uatomic_t      nConvClaim;     // Index of the next convolver to process in the current block
+                size_t                  nConvSamples;   // Number of samples in the current block of convolvers
 
                 input_t                 vInputs[2];
                 channel_t               vChannels[2];
@@ -217,6 +445,15 @@ namespace lsp
 
                 IRConfigurator          sConfigurator;
                 GCTask                  sGCTask;
+                SamplePool              sPool;          // Pool of samples used by the configurator
+                ExecutorTask            sExecutorTask;  // Task that attaches the instance to the worker pool
+                ConvolverTask           vConvTasks[meta::impulse_reverb_metadata::CONVOLVERS - 1];  // Offline processing of convolvers by the worker pool
+                WorkerQueue             sQueue;         // Task queue in the worker pool
+                perf::timing_t          vStages[STG_TOTAL];     // Timing of processing stages
+                perf::timing_t          sConfigTime;    // Timing of the reconfiguration
+                perf::timing_t          sGCTime;        // Timing of the garbage collection
+                perf::timing_t          sReconfigLatency;   // Time from reconfiguration request to data swap
+                perf::timing_t          sRestoreTime;   // Time from state restore to data swap
 
                 plug::IPort            *pBypass;
                 plug::IPort            *pRank;
@@ -227,9 +464,25 @@ namespace lsp
                 plug::IPort            *pPredelay;
                 plug::IPort            *pWetEq;         // Wet equalization flag
                 plug::IPort            *pWetSplit;      // Equalizer L/R split
+                plug::IPort            *pXFade;         // Convolver crossfade time
+                plug::IPort            *pBankMem;       // IR bank memory budget
+                plug::IPort            *pLean;          // Memory-lean mode
+                plug::IPort            *pEmbed;         // Embed impulse response data into the state
+                plug::IPort            *pReconfMem;     // Reconfiguration memory budget
+                plug::IPort            *pWorkers;       // Number of worker pool threads
+                plug::IPort            *pWorkerPrio;    // Priority of worker pool threads
+                plug::IPort            *pOffline;       // Offline rendering mode
+                plug::IPort            *pDeadline;      // Deadline, fraction of the block duration
+                plug::IPort            *pCpuLoad;       // CPU load meter
+                plug::IPort            *pMisses;        // Deadline misses counter
+                plug::IPort            *pReconfigLatency;   // Reconfiguration latency
+                plug::IPort            *pMemory;        // Memory usage meter
+                plug::IPort            *pMemPeak;       // Peak memory usage meter
 
                 uint8_t                *pData;
                 ipc::IExecutor         *pExecutor;
+                ipc::IExecutor         *pHostExecutor;  // Executor provided by the host
+                WorkerPool             *pPool;          // Worker pool, NULL if the host executor is used
 
             protected:
                 void                do_destroy();
@@ -247,12 +500,21 @@ namespace lsp
                 virtual void        destroy() override;
 
             public:
+                virtual void        activated() override;
                 virtual void        ui_activated() override;
+                virtual void        state_loaded() override;
                 virtual void        update_settings() override;
                 virtual void        update_sample_rate(long sr) override;
 
                 virtual void        process(size_t samples) override;
 
+                /**
+                 * Check that there are no pending file loads, reconfigurations and crossfades,
+                 * used by offline hosts to wait until the impulse responses are ready
+                 * @return true if the plugin processes audio with the final impulse responses
+                 */
+                bool                settled();
+
                 void                dump(dspu::IStateDumper *v) const override;
         };
     } /* namespace plugins */
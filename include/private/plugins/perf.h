@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLUGINS_PERF_H_
+#define PRIVATE_PLUGINS_PERF_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/dsp-units/iface/IStateDumper.h>
+
+namespace lsp
+{
+    namespace plugins
+    {
+        namespace perf
+        {
+            /**
+             * Timing statistics of the processing stage
+             */
+            typedef struct timing_t
+            {
+                uint64_t            nStart;         // Start of the current measurement
+                uint64_t            nLast;          // Duration of the last measurement, ns
+                uint64_t            nMax;           // Worst-case duration, ns
+                float               fAvg;           // Rolling average duration, ns
+                size_t              nCount;         // Number of measurements
+            } timing_t;
+
+            /**
+             * Get the value of the monotonic clock
+             * @return value of the monotonic clock in nanoseconds
+             */
+            uint64_t    now();
+
+            /**
+             * Initialize timing statistics
+             * @param t timing statistics
+             */
+            void        init(timing_t *t);
+
+            /**
+             * Commit the measured duration to the statistics
+             * @param t timing statistics
+             * @param duration measured duration in nanoseconds
+             */
+            void        commit(timing_t *t, uint64_t duration);
+
+            /**
+             * Start the measurement
+             * @param t timing statistics
+             */
+            inline void start(timing_t *t)          { t->nStart = now();                    }
+
+            /**
+             * Finish the measurement and commit it to the statistics
+             * @param t timing statistics
+             * @return the measured duration in nanoseconds
+             */
+            inline uint64_t stop(timing_t *t)
+            {
+                const uint64_t duration = now() - t->nStart;
+                commit(t, duration);
+                return duration;
+            }
+
+            /**
+             * Dump timing statistics
+             * @param v state dumper
+             * @param name name of the object, NULL for array element
+             * @param t timing statistics
+             */
+            void        dump(dspu::IStateDumper *v, const char *name, const timing_t *t);
+        } /* namespace perf */
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#endif /* PRIVATE_PLUGINS_PERF_H_ */
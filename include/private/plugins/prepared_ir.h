@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLUGINS_PREPARED_IR_H_
+#define PRIVATE_PLUGINS_PREPARED_IR_H_
+
+#include <lsp-plug.in/common/types.h>
+
+namespace lsp
+{
+    namespace plugins
+    {
+        /**
+         * Prepared impulse response file (*.lir).
+         *
+         * The file contains impulse response which is already resampled to the target
+         * sample rate, trimmed and faded, so the plugin does not need to decode or
+         * resample it.
+         * The layout of the file is:
+         *   - header (prepared_ir_header_t), all fields are little-endian;
+         *   - nChannels tracks of nLength 32-bit little-endian IEEE floats each,
+         *     tracks are stored one after another starting at nHeaderSize offset.
+         */
+        static constexpr uint32_t PREPARED_IR_VERSION   = 2;
+        static constexpr const char *PREPARED_IR_EXT    = ".lir";
+
+        #pragma pack(push, 1)
+        typedef struct prepared_ir_header_t
+        {
+            char        vSignature[4];  // File signature, "LIRP"
+            uint32_t    nVersion;       // Format version
+            uint32_t    nHeaderSize;    // Size of the header, offset of the first track
+            uint32_t    nChannels;      // Number of tracks
+            uint32_t    nLength;        // Length of each track in samples
+            uint32_t    nSampleRate;    // Sample rate the data was prepared for
+            float       fPeak;          // Peak value of the original file before resampling, used for normalization
+            float       fGate;          // Tail gate applied relative to the peak, dB, 0 if the tail was not trimmed
+            float       fFadeOut;       // Fade-out applied at the end of each track, ms
+        } prepared_ir_header_t;
+        #pragma pack(pop)
+
+        inline bool prepared_ir_signature(const prepared_ir_header_t *hdr)
+        {
+            return (hdr->vSignature[0] == 'L') && (hdr->vSignature[1] == 'I') &&
+                   (hdr->vSignature[2] == 'R') && (hdr->vSignature[3] == 'P');
+        }
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#endif /* PRIVATE_PLUGINS_PREPARED_IR_H_ */
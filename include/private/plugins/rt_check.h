@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLUGINS_RT_CHECK_H_
+#define PRIVATE_PLUGINS_RT_CHECK_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/finally.h>
+
+/**
+ * Real-time safety verification mode.
+ *
+ * When the project is configured with RT_CHECK=1 (-DLSP_IR_RT_CHECK), the code enclosed
+ * with IR_RT_SCOPE is considered to be real-time. Any call of memory allocation/deallocation routines or
+ * mutex locking on the thread which is inside of the real-time scope is reported as
+ * violation and the process is aborted. Without the flag the scope costs nothing.
+ */
+namespace lsp
+{
+    namespace plugins
+    {
+        namespace rt_check
+        {
+            /**
+             * Enter the real-time scope on the current thread
+             */
+            void        enter();
+
+            /**
+             * Leave the real-time scope on the current thread
+             */
+            void        leave();
+
+            /**
+             * Check that the current thread is inside of the real-time scope
+             * @return true if the current thread is inside of the real-time scope
+             */
+            bool        active();
+
+            /**
+             * Report violation of real-time safety and abort the process
+             * @param what the name of the called routine
+             */
+            void        violation(const char *what);
+        } /* namespace rt_check */
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#ifdef LSP_IR_RT_CHECK
+    #define IR_RT_SCOPE \
+        ::lsp::plugins::rt_check::enter(); \
+        lsp_finally { ::lsp::plugins::rt_check::leave(); }
+#else
+    #define IR_RT_SCOPE
+#endif /* LSP_IR_RT_CHECK */
+
+#endif /* PRIVATE_PLUGINS_RT_CHECK_H_ */
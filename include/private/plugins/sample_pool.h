@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLUGINS_SAMPLE_POOL_H_
+#define PRIVATE_PLUGINS_SAMPLE_POOL_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/dsp-units/iface/IStateDumper.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+
+namespace lsp
+{
+    namespace plugins
+    {
+        /**
+         * Pool of samples which recycles sample buffers of matching size classes
+         * instead of freeing and allocating them again. The pool is not thread-safe
+         * and should be used by one thread at a time.
+         */
+        class SamplePool
+        {
+            private:
+                static constexpr size_t ITEMS_MAX   = 16;
+
+            private:
+                dspu::Sample       *vItems[ITEMS_MAX];  // Recycled samples, the oldest goes first
+                size_t              nItems;             // Number of recycled samples
+                size_t              nBytes;             // Memory held by recycled samples, bytes
+                size_t              nLimit;             // Maximum memory held by recycled samples, bytes
+                size_t              nRequests;          // Number of allocation requests
+                size_t              nHits;              // Number of requests served by recycled samples
+                size_t              nEvicted;           // Number of recycled samples freed to stay within limits
+
+            protected:
+                static size_t       size_class(size_t length);
+                static size_t       sample_bytes(const dspu::Sample *s);
+                static void         free_sample(dspu::Sample *s);
+                void                evict(size_t index);
+
+            public:
+                SamplePool();
+                SamplePool(const SamplePool &) = delete;
+                SamplePool(SamplePool &&) = delete;
+                ~SamplePool();
+
+                SamplePool & operator = (const SamplePool &) = delete;
+                SamplePool & operator = (SamplePool &&) = delete;
+
+                void                destroy();
+
+            public:
+                /**
+                 * Set the maximum amount of memory held by recycled samples
+                 * @param limit maximum amount of memory in bytes
+                 */
+                void                set_limit(size_t limit);
+
+                /**
+                 * Get memory held by recycled samples
+                 * @return memory held by recycled samples in bytes
+                 */
+                inline size_t       bytes() const       { return nBytes;        }
+
+                /**
+                 * Allocate sample, the contents of the sample are undefined
+                 * @param channels number of channels
+                 * @param length length of the sample in samples
+                 * @return allocated sample or NULL if there is no memory
+                 */
+                dspu::Sample       *alloc(size_t channels, size_t length);
+
+                /**
+                 * Return the sample to the pool and reset the pointer
+                 * @param s sample to return, can be NULL
+                 */
+                void                release(dspu::Sample * &s);
+
+                /**
+                 * Free all recycled samples
+                 */
+                void                clear();
+
+                void                dump(dspu::IStateDumper *v) const;
+        };
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#endif /* PRIVATE_PLUGINS_SAMPLE_POOL_H_ */
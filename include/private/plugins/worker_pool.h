@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLUGINS_WORKER_POOL_H_
+#define PRIVATE_PLUGINS_WORKER_POOL_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/dsp-units/iface/IStateDumper.h>
+#include <lsp-plug.in/ipc/IExecutor.h>
+#include <lsp-plug.in/ipc/ITask.h>
+#include <lsp-plug.in/ipc/Mutex.h>
+#include <lsp-plug.in/ipc/Thread.h>
+
+#if defined(PLATFORM_LINUX)
+    #include <semaphore.h>
+#endif /* PLATFORM_LINUX */
+
+namespace lsp
+{
+    namespace plugins
+    {
+        class WorkerPool;
+
+        /**
+         * Priority of the worker threads
+         */
+        enum worker_priority_t
+        {
+            WP_NORMAL,          // Same priority as the host's threads
+            WP_LOW,             // Lowered priority
+            WP_IDLE             // Run only when the system has nothing else to do
+        };
+
+        /**
+         * Task queue of the plugin instance. Tasks are submitted by the real-time thread
+         * without locking and are executed by the threads of the shared worker pool.
+         */
+        class WorkerQueue: public ipc::IExecutor
+        {
+            private:
+                friend class WorkerPool;
+
+                static constexpr size_t CAPACITY    = 0x10;
+
+            private:
+                ipc::ITask         *vTasks[CAPACITY];   // Ring buffer of submitted tasks
+                volatile uatomic_t  nHead;              // Index of the next task to execute
+                volatile uatomic_t  nTail;              // Index of the next task to submit
+                volatile uatomic_t  nRunning;           // Number of tasks being executed
+                size_t              nThreads;           // Number of worker threads requested by the instance
+                size_t              nPriority;          // Worker priority requested by the instance
+                WorkerQueue        *pNext;              // Next queue in the pool
+                WorkerPool         *pPool;              // Pool the queue is attached to
+
+            protected:
+                ipc::ITask         *take();
+                void                execute(ipc::ITask *task);
+                void                drop();
+                bool                remove(ipc::ITask *task);
+
+            public:
+                explicit WorkerQueue();
+                WorkerQueue(const WorkerQueue &) = delete;
+                WorkerQueue(WorkerQueue &&) = delete;
+                virtual ~WorkerQueue() override;
+
+                WorkerQueue & operator = (const WorkerQueue &) = delete;
+                WorkerQueue & operator = (WorkerQueue &&) = delete;
+
+            public:
+                virtual bool        submit(ipc::ITask *task) override;
+                virtual void        shutdown() override;
+
+            public:
+                /**
+                 * Withdraw the submitted task which has not been taken by workers yet, the task
+                 * becomes idle. Should be called by the thread that submits tasks.
+                 * @param task task to withdraw
+                 * @return true if the task has been withdrawn, false if it is not pending in the queue
+                 */
+                bool                withdraw(ipc::ITask *task);
+
+                inline bool         attached() const    { return pPool != NULL; }
+                void                dump(dspu::IStateDumper *v) const;
+        };
+
+        /**
+         * Process-wide pool of worker threads shared by all plugin instances. Idle workers
+         * take tasks from the queues of all instances in round-robin order, so pending tasks
+         * of one instance do not delay other instances. Several tasks of the same queue can
+         * be executed concurrently.
+         */
+        class WorkerPool
+        {
+            private:
+                friend class WorkerQueue;
+
+                static constexpr size_t THREADS_MAX = 16;
+
+                class Worker: public ipc::Thread
+                {
+                    private:
+                        WorkerPool         *pPool;
+                        volatile bool       bStop;          // Worker should stop
+                        size_t              nPriority;      // Currently applied priority
+
+                    public:
+                        explicit Worker(WorkerPool *pool);
+                        virtual ~Worker() override;
+
+                    public:
+                        virtual status_t    run() override;
+                        inline void         stop()          { bStop = true;     }
+                };
+
+            private:
+                ipc::Mutex          sLock;              // Lock of the queue list and workers
+                WorkerQueue        *pQueues;            // List of attached queues
+                WorkerQueue        *pCursor;            // Queue to check first for the next task
+                Worker             *vWorkers[THREADS_MAX];
+                size_t              nWorkers;           // Number of started workers
+            #if defined(PLATFORM_LINUX)
+                sem_t               hTasks;             // Posted for each submitted task
+            #endif /* PLATFORM_LINUX */
+                volatile size_t     nPriority;          // Requested priority of workers
+                size_t              nReferences;        // Number of plugin instances using the pool
+
+            private:
+                static WorkerPool  *pInstance;
+                static ipc::Mutex   sInstanceLock;
+
+            protected:
+                ipc::ITask         *next_task(WorkerQueue **queue);
+                bool                withdraw(WorkerQueue *queue, ipc::ITask *task);
+                size_t              resize(size_t threads, bool restart, Worker **stopped);
+                size_t              update(Worker **stopped);
+                void                wait_task();
+                void                post_task();
+                static void         apply_priority(size_t priority);
+                static void         join_workers(Worker **stopped, size_t count);
+
+            public:
+                explicit WorkerPool();
+                WorkerPool(const WorkerPool &) = delete;
+                WorkerPool(WorkerPool &&) = delete;
+                ~WorkerPool();
+
+                WorkerPool & operator = (const WorkerPool &) = delete;
+                WorkerPool & operator = (WorkerPool &&) = delete;
+
+            public:
+                /**
+                 * Obtain the process-wide pool, the pool is created on first request
+                 * @return pointer to the pool or NULL if there is no memory
+                 */
+                static WorkerPool  *acquire();
+
+                /**
+                 * Release the pool obtained by acquire(), the last release destroys the pool
+                 */
+                void                release();
+
+                /**
+                 * Set number of threads and priority requested by the attached queue, the pool
+                 * runs the maximum number of threads with the highest priority over all attached queues
+                 * @param queue attached queue
+                 * @param threads number of threads
+                 * @param priority priority of the threads
+                 */
+                void                configure(WorkerQueue *queue, size_t threads, worker_priority_t priority);
+
+                /**
+                 * Attach the queue to the pool
+                 * @param queue queue to attach
+                 */
+                void                attach(WorkerQueue *queue);
+
+                /**
+                 * Detach the queue from the pool and wait until its tasks finish execution,
+                 * the tasks that have not been started yet are dropped
+                 * and become idle
+                 * @param queue queue to detach
+                 */
+                void                detach(WorkerQueue *queue);
+        };
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#endif /* PRIVATE_PLUGINS_WORKER_POOL_H_ */
@@ -203,6 +203,7 @@ ifndef PKGCONFIG_EXT
 endif
 
 TEST                       := 0
+RT_CHECK                   := 0
 
 # Set-up list of common variables
 COMMON_VARS = \
@@ -224,6 +225,7 @@ COMMON_VARS = \
 	PLATFORM \
 	ROOT_ARTIFACT_ID \
 	PROFILE \
+	RT_CHECK \
 	STATICLIB_EXT \
 	STRICT \
 	TEST \
@@ -250,6 +252,7 @@ sysvars:
 	echo "  PKGCONFIG_EXT             file extension for pkgconfig files"
 	echo "  PLATFORM                  target software platform to perform build"
 	echo "  PROFILE                   build with profile options"
+	echo "  RT_CHECK                  build with real-time safety checker (LSP_IR_RT_CHECK)"
 	echo "  STATICLIB_EXT             file extension for static library files"
 	echo "  STRICT                    strict compilation: treat compilation warnings as errors"
 	echo "  SUB_FEATURES              list of features disabled in the build as a subtraction of default"
@@ -148,6 +148,11 @@ ifeq ($(STRICT),1)
   NOARCH_CXXFLAGS    += -Werror
 endif
 
+ifeq ($(RT_CHECK),1)
+  NOARCH_CFLAGS      += -DLSP_IR_RT_CHECK
+  NOARCH_CXXFLAGS    += -DLSP_IR_RT_CHECK
+endif
+
 ifeq ($(TEST),1)
   NOARCH_CFLAGS      += -DLSP_TESTING
   NOARCH_CXXFLAGS    += -DLSP_TESTING
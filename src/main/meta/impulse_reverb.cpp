@@ -28,7 +28,7 @@
 
 #define LSP_PLUGINS_IMPULSE_REVERB_VERSION_MAJOR       1
 #define LSP_PLUGINS_IMPULSE_REVERB_VERSION_MINOR       0
-#define LSP_PLUGINS_IMPULSE_REVERB_VERSION_MICRO       32
+#define LSP_PLUGINS_IMPULSE_REVERB_VERSION_MICRO       33
 
 #define LSP_PLUGINS_IMPULSE_REVERB_VERSION  \
     LSP_MODULE_VERSION( \
@@ -44,6 +44,7 @@ namespace lsp
         // Lisf of different revisions for adding controls
         #define REV_0       0
         #define REV_1       1
+        #define REV_2       2
 
         //-------------------------------------------------------------------------
         // Impulse reverb
@@ -93,6 +94,14 @@ namespace lsp
             { NULL, NULL }
         };
 
+        static const port_item_t ir_worker_priority[] =
+        {
+            { "Normal",     "engine.priority.normal" },
+            { "Low",        "engine.priority.low" },
+            { "Idle",       "engine.priority.idle" },
+            { NULL, NULL }
+        };
+
         static const port_item_t filter_slope[] =
         {
             { "off",        "eq.slope.off" },
@@ -171,6 +180,50 @@ namespace lsp
             IR_EQ_BANDS(REV_0, "", "", ""), \
             IR_EQ_BANDS(REV_1, "r", "Right ", "R ")
 
+        #define IR_ENGINE \
+            ADDON_SWITCH(REV_2, "egv", "Engine settings visibility", "Show engine", 0.0f), \
+            ADDON_CONTROL(REV_2, "xft", "Convolver crossfade time", "Xfade", U_MSEC, impulse_reverb_metadata::XFADE), \
+            ADDON_CONTROL(REV_2, "bkm", "IR bank memory budget", "Bank mem", U_MBYTES, impulse_reverb_metadata::BANK_MEM), \
+            ADDON_SWITCH(REV_2, "lean", "Memory-lean mode", "Lean mem", 0.0f), \
+            ADDON_SWITCH(REV_2, "emb", "Embed IR data into state", "Embed IR", 0.0f), \
+            ADDON_CONTROL(REV_2, "rcm", "Reconfiguration memory budget", "Reconf mem", U_MBYTES, impulse_reverb_metadata::RECONF_MEM), \
+            ADDON_CONTROL(REV_2, "wpt", "Worker pool threads", "Workers", U_NONE, impulse_reverb_metadata::WORKERS), \
+            ADDON_COMBO(REV_2, "wkp", "Worker pool priority", "Worker prio", 1, ir_worker_priority), \
+            ADDON_SWITCH(REV_2, "ofl", "Offline rendering mode", "Offline", 0.0f)
+
+        #define IR_CONVOLVER_EXT(id, label) \
+            ADDON_SWITCH(REV_2, "cbm" id, "Channel IR bank mode" label, "Bank" label, 0.0f), \
+            ADDON_COMBO(REV_2, "cmf" id, "Channel morph target file" label, "Morph src" label, 0, ir_files), \
+            ADDON_CONTROL(REV_2, "cmx" id, "Channel morph amount" label, "Morph" label, U_PERCENT, impulse_reverb_metadata::MORPH)
+
+        #define IR_CONVOLVERS_EXT \
+            IR_CONVOLVER_EXT("0", " 0"), \
+            IR_CONVOLVER_EXT("1", " 1"), \
+            IR_CONVOLVER_EXT("2", " 2"), \
+            IR_CONVOLVER_EXT("3", " 3")
+
+        #define IR_FILE_MEMORY(id, label) \
+            METER("ifm" id, "File memory usage" label, U_MBYTES, impulse_reverb_metadata::MEMORY)
+
+        #define IR_CONVOLVER_MEMORY(id, label) \
+            METER("cvm" id, "Channel convolver memory usage" label, U_MBYTES, impulse_reverb_metadata::MEMORY)
+
+        #define IR_TELEMETRY \
+            ADDON_CONTROL(REV_2, "dlf", "Deadline fraction of block duration", "Deadline", U_PERCENT, impulse_reverb_metadata::DEADLINE), \
+            METER("cpu", "CPU load", U_PERCENT, impulse_reverb_metadata::CPU_LOAD), \
+            METER("dlm", "Deadline misses", U_NONE, impulse_reverb_metadata::MISSES), \
+            METER("rcl", "Reconfiguration latency", U_MSEC, impulse_reverb_metadata::RECONFIG), \
+            METER("mem", "Memory usage", U_MBYTES, impulse_reverb_metadata::MEMORY), \
+            METER("mpk", "Peak memory usage", U_MBYTES, impulse_reverb_metadata::MEMORY), \
+            IR_FILE_MEMORY("0", " 0"), \
+            IR_FILE_MEMORY("1", " 1"), \
+            IR_FILE_MEMORY("2", " 2"), \
+            IR_FILE_MEMORY("3", " 3"), \
+            IR_CONVOLVER_MEMORY("0", " 0"), \
+            IR_CONVOLVER_MEMORY("1", " 1"), \
+            IR_CONVOLVER_MEMORY("2", " 2"), \
+            IR_CONVOLVER_MEMORY("3", " 3")
+
         static const port_t impulse_reverb_mono_ports[] =
         {
             // Input audio ports
@@ -191,6 +244,13 @@ namespace lsp
             // Impulse response equalizer
             IR_EQUALIZER,
 
+            // Convolution engine settings
+            IR_ENGINE,
+            IR_CONVOLVERS_EXT,
+
+            // Performance telemetry
+            IR_TELEMETRY,
+
             PORTS_END
         };
 
@@ -213,6 +273,13 @@ namespace lsp
             // Impulse response equalizer
             IR_EQUALIZER,
 
+            // Convolution engine settings
+            IR_ENGINE,
+            IR_CONVOLVERS_EXT,
+
+            // Performance telemetry
+            IR_TELEMETRY,
+
             PORTS_END
         };
 
@@ -251,7 +318,7 @@ namespace lsp
             LSP_PLUGINS_IMPULSE_REVERB_VERSION,
             plugin_classes,
             clap_features_mono,
-            E_DUMP_STATE | E_FILE_PREVIEW,
+            E_DUMP_STATE | E_FILE_PREVIEW | E_KVT_SYNC,
             impulse_reverb_mono_ports,
             "plugins/convolution/impulse_reverb/mono.xml",
             NULL,
@@ -283,7 +350,7 @@ namespace lsp
             LSP_PLUGINS_IMPULSE_REVERB_VERSION,
             plugin_classes,
             clap_features_stereo,
-            E_DUMP_STATE | E_FILE_PREVIEW,
+            E_DUMP_STATE | E_FILE_PREVIEW | E_KVT_SYNC,
             impulse_reverb_stereo_ports,
             "plugins/convolution/impulse_reverb/stereo.xml",
             NULL,
@@ -20,21 +20,68 @@
  */
 
 #include <private/plugins/impulse_reverb.h>
+#include <private/plugins/prepared_ir.h>
+#include <private/plugins/perf.h>
+#include <private/plugins/rt_check.h>
 #include <lsp-plug.in/common/alloc.h>
 #include <lsp-plug.in/common/atomic.h>
 #include <lsp-plug.in/common/debug.h>
+#include <lsp-plug.in/common/endian.h>
 #include <lsp-plug.in/dsp/dsp.h>
 #include <lsp-plug.in/dsp-units/units.h>
 #include <lsp-plug.in/dsp-units/misc/fade.h>
+#include <lsp-plug.in/io/NativeFile.h>
+#include <lsp-plug.in/mm/InAudioFileStream.h>
+#include <lsp-plug.in/plug-fw/core/KVTStorage.h>
 #include <lsp-plug.in/plug-fw/meta/func.h>
 #include <lsp-plug.in/shared/debug.h>
 
+#if defined(PLATFORM_UNIX_COMPATIBLE) && defined(ARCH_LE)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+
+    #define IR_MAPPED_WAV_SUPPORTED
+#endif /* PLATFORM_UNIX_COMPATIBLE && ARCH_LE */
+
 namespace lsp
 {
     namespace plugins
     {
         static constexpr size_t TMP_BUF_SIZE    = 0x1000;
+        static constexpr size_t OFFLINE_BUF_SIZE= 0x4000;   // Size of the processing block in offline mode
         static constexpr size_t CONV_RANK       = 10;
+        static constexpr size_t TRACKS_VISIBLE  = 0x03;     // Tracks that are always loaded for thumbnails and preview
+        static constexpr size_t STREAM_CHUNK    = 0x4000;   // Size of the chunk for streaming decode, samples
+        static constexpr size_t PEAK_BLOCK      = 0x100;    // Number of samples per block of the finest peak level
+        static constexpr float CPU_LOAD_SMOOTH  = 0.1f;     // Smoothing factor of the CPU load meter
+        static constexpr float RESTORE_HOLD     = 200.0f;   // Time to wait for other files of the restored state, ms
+        static constexpr float MORPH_SETTLE     = 50.0f;    // Time the morphing should stay unchanged to rebuild the convolver, ms
+        static constexpr size_t POOL_LIMIT      = 0x4000000;    // Maximum memory held by recycled samples, bytes
+        static constexpr uint32_t IR_BLOB_MAGIC = 0x4c495242;   // 'LIRB'
+        static constexpr uint32_t IR_BLOB_VERSION = 3;
+        static constexpr size_t EMBED_MARGIN    = 0x100;    // Samples stored around the cut range of embedded data for the resampler
+
+        // Header of the impulse response data embedded into the plugin state, the planar 32-bit
+        // float data of each track follows the header. Only the samples used by the cut settings are stored.
+        typedef struct ir_blob_header_t
+        {
+            uint32_t    nMagic;         // Magic number, also determines byte order
+            uint32_t    nVersion;       // Version of the blob format
+            uint32_t    nChannels;      // Number of stored tracks
+            uint32_t    nLength;        // Length of each track in samples
+            uint32_t    nSampleRate;    // Sample rate
+            uint32_t    nMask;          // Mask of stored tracks
+            float       fPeak;          // Peak value of the original file
+            uint32_t    nSrcChannels;   // Number of tracks in the original file
+            uint32_t    nFlags;         // Flags of the stored data
+            uint32_t    nOffset;        // Index of the first stored sample
+            uint32_t    nStored;        // Number of stored samples of each track, other samples are zero
+        } ir_blob_header_t;
+
+        // Memory reserved by reconfigurations of all plugin instances in the process, kilobytes
+        static volatile atomic_t nGlobalReserved    = 0;
 
         //---------------------------------------------------------------------
         // Plugin factory
@@ -82,6 +129,9 @@ namespace lsp
             dsp::start(&ctx);
             lsp_finally { dsp::finish(&ctx); };
 
+            perf::start(&pDescr->sLoadTime);
+            lsp_finally { perf::stop(&pDescr->sLoadTime); };
+
             return pCore->load(pDescr);
         }
 
@@ -108,6 +158,9 @@ namespace lsp
             dsp::start(&ctx);
             lsp_finally { dsp::finish(&ctx); };
 
+            perf::start(&pCore->sConfigTime);
+            lsp_finally { perf::stop(&pCore->sConfigTime); };
+
             return pCore->reconfigure();
         }
 
@@ -129,6 +182,9 @@ namespace lsp
 
         status_t impulse_reverb::GCTask::run()
         {
+            perf::start(&pCore->sGCTime);
+            lsp_finally { perf::stop(&pCore->sGCTime); };
+
             pCore->perform_gc();
             return STATUS_OK;
         }
@@ -138,11 +194,60 @@ namespace lsp
             v->write("pCore", pCore);
         }
 
+        //-------------------------------------------------------------------------
+        void impulse_reverb::ConvolverTask::init(impulse_reverb *base)
+        {
+            pCore       = base;
+        }
+
+        impulse_reverb::ConvolverTask::~ConvolverTask()
+        {
+            pCore       = NULL;
+        }
+
+        status_t impulse_reverb::ConvolverTask::run()
+        {
+            // Worker threads do not have the DSP context of the host's processing thread
+            dsp::context_t ctx;
+            dsp::start(&ctx);
+            lsp_finally { dsp::finish(&ctx); };
+
+            pCore->run_convolvers();
+            return STATUS_OK;
+        }
+
+        void impulse_reverb::ConvolverTask::dump(dspu::IStateDumper *v) const
+        {
+            v->write("pCore", pCore);
+        }
+
+        //-------------------------------------------------------------------------
+        impulse_reverb::ExecutorTask::ExecutorTask(impulse_reverb *base)
+        {
+            pCore       = base;
+        }
+
+        impulse_reverb::ExecutorTask::~ExecutorTask()
+        {
+            pCore       = NULL;
+        }
+
+        status_t impulse_reverb::ExecutorTask::run()
+        {
+            return pCore->configure_executor();
+        }
+
+        void impulse_reverb::ExecutorTask::dump(dspu::IStateDumper *v) const
+        {
+            v->write("pCore", pCore);
+        }
+
         //-------------------------------------------------------------------------
         impulse_reverb::impulse_reverb(const meta::plugin_t *metadata):
             plug::Module(metadata),
             sConfigurator(this),
-            sGCTask(this)
+            sGCTask(this),
+            sExecutorTask(this)
         {
             nInputs         = 0;
             for (const meta::port_t *p = metadata->ports; p->id != NULL; ++p)
@@ -152,7 +257,47 @@ namespace lsp
             nReconfigReq    = 0;
             nReconfigResp   = -1;
             nRank           = 0;
+            nBlockSize      = TMP_BUF_SIZE;
+            bOffline        = false;
+            nXFade          = 0;
+            nBankMem        = 0;
+            nReconfMem      = 0;
+            nReserved       = 0;
+            bDeferPending   = false;
+            bDeferPass      = false;
+            bFlush          = false;
+            bFlushPass      = false;
+            bRestore        = false;
+            bRestoreBatch   = false;
+            bRestoreConfig  = false;
+            bRestoreCheck   = false;
+            nRestoreHold    = 0;
+            nWorkers        = 0;
+            nWorkerPrio     = WP_LOW;
+            nPoolWorkers    = 0;
+            nPoolPrio       = WP_LOW;
+            bLean           = false;
+            bSnapGains      = true;
+            fCpuLoad        = 0.0f;
+            nMemPeak        = 0;
+            fDeadline       = meta::impulse_reverb_metadata::DEADLINE_DFL * 0.01f;
+            nMisses         = 0;
+            for (size_t i=0; i<MISS_TOTAL; ++i)
+                vMissCause[i]   = 0;
+            nReqTime        = 0;
+            nSubmitTime     = 0;
+            for (size_t i=0; i<STG_TOTAL; ++i)
+                perf::init(&vStages[i]);
+            perf::init(&sConfigTime);
+            perf::init(&sGCTime);
+            perf::init(&sReconfigLatency);
+            perf::init(&sRestoreTime);
+            bEmbed          = false;
             pGCList         = NULL;
+            nConvClaim      = 0;
+            nConvSamples    = 0;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS - 1; ++i)
+                vConvTasks[i].init(this);
 
             for (size_t i=0; i<2; ++i)
             {
@@ -170,6 +315,15 @@ namespace lsp
                 c->vBuffer      = NULL;
                 c->fDryPan[0]   = 0.0f;
                 c->fDryPan[1]   = 0.0f;
+                c->fOldDryPan[0]= 0.0f;
+                c->fOldDryPan[1]= 0.0f;
+                for (size_t j=0; j<meta::impulse_reverb_metadata::EQ_BANDS; ++j)
+                    c->vEqGain[j]   = 0.0f;
+                c->fLowFreq     = 0.0f;
+                c->fHighFreq    = 0.0f;
+                c->nLowSlope    = 0;
+                c->nHighSlope   = 0;
+                c->bEqReset     = true;
 
                 c->pOut         = NULL;
                 c->pLowCut      = NULL;
@@ -187,15 +341,49 @@ namespace lsp
 
                 c->pCurr            = NULL;
                 c->pSwap            = NULL;
+                c->nCurrMem         = 0;
+                c->nSwapMem         = 0;
+                c->bDefer           = false;
+                c->bKeep            = false;
+                c->bRebuild         = false;
+                c->bStale           = false;
+
+                for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                {
+                    c->vBank[j]         = NULL;
+                    c->vBankSwap[j]     = NULL;
+                    c->vBankMem[j]      = 0;
+                    c->vBankSwapMem[j]  = 0;
+                    c->vStale[j]        = false;
+                }
+
+                c->sFade.pOld       = NULL;
+                c->sFade.nPos       = 0;
+                c->sFade.nLen       = 0;
+                c->nBuildReq        = 0;
+                c->nBuildResp       = 0;
+
+                c->bMute            = false;
+                c->bBank            = false;
+                c->bBankSwap        = false;
+                c->bBankReq         = false;
 
                 c->nFile            = 0;
                 c->nTrack           = 0;
+                c->nMorphFile       = 0;
+                c->fMorph           = 0.0f;
+                c->nMorphHold       = 0;
 
                 c->vBuffer          = NULL;
+                c->vTemp            = NULL;
                 c->fPanIn[0]        = 0.0f;
                 c->fPanIn[1]        = 0.0f;
                 c->fPanOut[0]       = 0.0f;
                 c->fPanOut[1]       = 0.0f;
+                c->fOldPanIn[0]     = 0.0f;
+                c->fOldPanIn[1]     = 0.0f;
+                c->fOldPanOut[0]    = 0.0f;
+                c->fOldPanOut[1]    = 0.0f;
 
                 c->pMakeup          = NULL;
                 c->pPanIn           = NULL;
@@ -205,6 +393,10 @@ namespace lsp
                 c->pPredelay        = NULL;
                 c->pMute            = NULL;
                 c->pActivity        = NULL;
+                c->pBank            = NULL;
+                c->pMorphFile       = NULL;
+                c->pMorph           = NULL;
+                c->pMemory          = NULL;
             }
 
             for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
@@ -213,15 +405,34 @@ namespace lsp
 
                 af->pOriginal       = NULL;
                 af->pProcessed      = NULL;
+                af->pRendered       = NULL;
+                af->pResampled      = NULL;
+                af->nResampleRate   = 0;
+                af->nResampleHead   = 0;
+                af->nResampleTail   = 0;
+                af->nSourceGen      = 0;
+                init_peaks(&af->sPeaks);
+                perf::init(&af->sLoadTime);
+                af->nMemory         = 0;
+                af->nPlayMem        = 0;
 
                 for (size_t j=0; j<meta::impulse_reverb_metadata::TRACKS_MAX; ++j)
                     af->vThumbs[j]      = NULL;
 
                 af->fNorm           = 0.0f;
                 af->nStatus         = STATUS_UNKNOWN_ERR;
+                af->nChannels       = 0;
+                af->nTracks         = 0;
+                af->nLoadMask       = 0;
+                af->nEmbedMask      = 0;
+                af->nEmbedFirst     = 0;
+                af->nEmbedLast      = ~size_t(0);
                 af->bRender         = true;
                 af->bSync           = true;
                 af->bReverse        = false;
+                af->bPreview        = false;
+                af->bPreviewDone    = false;
+                af->bReload         = false;
 
                 af->fPitch          = 0.0f;
                 af->fHeadCut        = 0.0f;
@@ -240,6 +451,7 @@ namespace lsp
                 af->pStatus         = NULL;
                 af->pLength         = NULL;
                 af->pThumbs         = NULL;
+                af->pMemory         = NULL;
             }
 
             pBypass         = NULL;
@@ -251,9 +463,25 @@ namespace lsp
             pPredelay       = NULL;
             pWetEq          = NULL;
             pWetSplit       = NULL;
+            pXFade          = NULL;
+            pBankMem        = NULL;
+            pLean           = NULL;
+            pEmbed          = NULL;
+            pReconfMem      = NULL;
+            pWorkers        = NULL;
+            pWorkerPrio     = NULL;
+            pOffline        = NULL;
+            pDeadline       = NULL;
+            pCpuLoad        = NULL;
+            pMisses         = NULL;
+            pReconfigLatency= NULL;
+            pMemory         = NULL;
+            pMemPeak        = NULL;
 
             pData           = NULL;
             pExecutor       = NULL;
+            pHostExecutor   = NULL;
+            pPool           = NULL;
         }
 
         impulse_reverb::~impulse_reverb()
@@ -266,6 +494,9 @@ namespace lsp
             // Destroy current file
             destroy_sample(af->pOriginal);
             destroy_sample(af->pProcessed);
+            destroy_sample(af->pRendered);
+            destroy_sample(af->pResampled);
+            destroy_peaks(&af->sPeaks);
 
             // Forget port
             af->pFile       = NULL;
@@ -291,7 +522,19 @@ namespace lsp
                 cv->pSwap    = NULL;
             }
 
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                destroy_convolver(cv->vBank[i]);
+                destroy_convolver(cv->vBankSwap[i]);
+                cv->vBankMem[i]     = 0;
+                cv->vBankSwapMem[i] = 0;
+            }
+
+            cv->nCurrMem        = 0;
+            cv->nSwapMem        = 0;
+            cv->sFade.pOld      = NULL;
             cv->vBuffer     = NULL;
+            cv->vTemp       = NULL;
         }
 
         void impulse_reverb::destroy_channel(channel_t *c)
@@ -351,19 +594,88 @@ namespace lsp
             return meta::impulse_reverb_metadata::FFT_RANK_MIN + rank;
         }
 
+        size_t impulse_reverb::convolver_size(size_t length, size_t rank)
+        {
+            // The partitioned spectrum takes about twice the length of the impulse response,
+            // additionally there are input and overlap buffers of the biggest partition
+            return (length * 2 + (size_t(4) << rank)) * sizeof(float);
+        }
+
+        size_t impulse_reverb::sample_memory(const dspu::Sample *s)
+        {
+            return (s != NULL) ? sizeof(dspu::Sample) + s->channels() * s->max_length() * sizeof(float) : 0;
+        }
+
+        size_t impulse_reverb::peaks_memory(const peaks_t *p)
+        {
+            return (p->pData != NULL) ? p->nChannels * p->nStride * sizeof(float) : 0;
+        }
+
+        size_t impulse_reverb::convolver_memory(const convolver_t *c)
+        {
+            // The swap convolvers keep the previous data until the next reconfiguration
+            size_t size         = c->nCurrMem + c->nSwapMem;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                size               += c->vBankMem[i] + c->vBankSwapMem[i];
+            return size;
+        }
+
+        void impulse_reverb::update_file_memory(af_descriptor_t *f)
+        {
+            // The preview sample is accounted separately since it is passed to the players
+            f->nMemory          =
+                sample_memory(f->pOriginal) +
+                sample_memory(f->pRendered) +
+                sample_memory(f->pResampled) +
+                peaks_memory(&f->sPeaks);
+        }
+
+        dspu::Convolver *impulse_reverb::active_convolver(const convolver_t *c)
+        {
+            // The source file selects the prepared entry in IR bank mode, stale convolvers stay silent until rebuilt
+            if (c->bMute)
+                return NULL;
+            if (!c->bBank)
+                return (c->bStale) ? NULL : c->pCurr;
+            if ((c->nFile <= 0) || (c->nFile > meta::impulse_reverb_metadata::FILES))
+                return NULL;
+            return (c->vStale[c->nFile - 1]) ? NULL : c->vBank[c->nFile - 1];
+        }
+
+        void impulse_reverb::mark_stale(convolver_t *c, const dspu::Convolver *cv)
+        {
+            // The convolver keeps the tail of the signal after it becomes inactive and would play it
+            // on the next activation, so it is replaced by the new one built in background
+            if (cv == NULL)
+                return;
+            if (cv == c->pCurr)
+                c->bStale           = true;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                if (cv == c->vBank[i])
+                    c->vStale[i]        = true;
+            ++c->nBuildReq;
+        }
+
+        dspu::Sample *impulse_reverb::rendered_sample(af_descriptor_t *af)
+        {
+            // In memory-lean mode the rendered sample is kept separately from the preview sample
+            return (af->pRendered != NULL) ? af->pRendered : af->pProcessed;
+        }
+
         void impulse_reverb::init(plug::IWrapper *wrapper, plug::IPort **ports)
         {
             // Pass wrapper
             plug::Module::init(wrapper, ports);
 
             // Remember executor service
-            pExecutor       = wrapper->executor();
+            pHostExecutor   = wrapper->executor();
+            pExecutor       = pHostExecutor;
             lsp_trace("Executor = %p", pExecutor);
 
-            // Allocate buffer data
-            size_t tmp_buf_size = TMP_BUF_SIZE * sizeof(float);
+            // Allocate buffer data, buffers should fit the processing block of offline mode
+            size_t tmp_buf_size = OFFLINE_BUF_SIZE * sizeof(float);
             size_t thumbs_size  = meta::impulse_reverb_metadata::MESH_SIZE * sizeof(float);
-            size_t alloc        = tmp_buf_size * (meta::impulse_reverb_metadata::CONVOLVERS + 2) +
+            size_t alloc        = tmp_buf_size * (meta::impulse_reverb_metadata::CONVOLVERS * 2 + 2) +
                                   thumbs_size * meta::impulse_reverb_metadata::TRACKS_MAX * meta::impulse_reverb_metadata::FILES;
             uint8_t *ptr        = alloc_aligned<uint8_t>(pData, alloc, DEFAULT_ALIGN);
             if (ptr == NULL)
@@ -388,6 +700,15 @@ namespace lsp
 
                 f->pOriginal    = NULL;
                 f->pProcessed   = NULL;
+                f->pRendered    = NULL;
+                f->pResampled   = NULL;
+                f->nResampleRate= 0;
+                f->nResampleHead= 0;
+                f->nResampleTail= 0;
+                f->nSourceGen   = 0;
+                init_peaks(&f->sPeaks);
+                f->nMemory      = 0;
+                f->nPlayMem     = 0;
 
                 for (size_t j=0; j<meta::impulse_reverb_metadata::TRACKS_MAX; ++j)
                 {
@@ -397,9 +718,18 @@ namespace lsp
 
                 f->fNorm        = 1.0f;
                 f->nStatus      = STATUS_UNSPECIFIED;
+                f->nChannels    = 0;
+                f->nTracks      = 0;
+                f->nLoadMask    = 0;
+                f->nEmbedMask   = 0;
+                f->nEmbedFirst  = 0;
+                f->nEmbedLast   = ~size_t(0);
                 f->bRender      = false;
                 f->bSync        = true;
                 f->bReverse     = false;
+                f->bPreview     = false;
+                f->bPreviewDone = false;
+                f->bReload      = false;
 
                 f->fPitch       = 0.0f;
                 f->fHeadCut     = 0.0f;
@@ -423,6 +753,7 @@ namespace lsp
                 f->pStatus      = NULL;
                 f->pLength      = NULL;
                 f->pThumbs      = NULL;
+                f->pMemory      = NULL;
             }
 
             // Initialize convolvers
@@ -432,16 +763,49 @@ namespace lsp
 
                 cv->pCurr           = NULL;
                 cv->pSwap           = NULL;
+                cv->nCurrMem        = 0;
+                cv->nSwapMem        = 0;
+                cv->bDefer          = false;
+                cv->bKeep           = false;
+                cv->bRebuild        = false;
+                cv->bMute           = false;
+                cv->bBank           = false;
+                cv->bBankSwap       = false;
+                cv->bBankReq        = false;
+                cv->bStale          = false;
+                for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                {
+                    cv->vBank[j]        = NULL;
+                    cv->vBankSwap[j]    = NULL;
+                    cv->vBankMem[j]     = 0;
+                    cv->vBankSwapMem[j] = 0;
+                    cv->vStale[j]       = false;
+                }
+                cv->sFade.pOld      = NULL;
+                cv->sFade.nPos      = 0;
+                cv->sFade.nLen      = 0;
+                cv->nBuildReq       = 0;
+                cv->nBuildResp      = 0;
                 cv->nFile           = 0;
                 cv->nTrack          = 0;
+                cv->nMorphFile      = 0;
+                cv->fMorph          = 0.0f;
+                cv->nMorphHold      = 0;
 
+                // Each convolver has own buffers, so convolvers can be processed concurrently in offline mode
                 cv->vBuffer         = reinterpret_cast<float *>(ptr);
                 ptr                += tmp_buf_size;
+                cv->vTemp           = reinterpret_cast<float *>(ptr);
+                ptr                += tmp_buf_size;
 
                 cv->fPanIn[0]       = 1.0f;
                 cv->fPanIn[1]       = 0.0f;
                 cv->fPanOut[0]      = 1.0f;
                 cv->fPanOut[1]      = 0.0f;
+                cv->fOldPanIn[0]    = 1.0f;
+                cv->fOldPanIn[1]    = 0.0f;
+                cv->fOldPanOut[0]   = 1.0f;
+                cv->fOldPanOut[1]   = 0.0f;
 
                 cv->pMakeup         = NULL;
                 cv->pPanIn          = NULL;
@@ -451,6 +815,10 @@ namespace lsp
                 cv->pPredelay       = NULL;
                 cv->pMute           = NULL;
                 cv->pActivity       = NULL;
+                cv->pBank           = NULL;
+                cv->pMorphFile      = NULL;
+                cv->pMorph          = NULL;
+                cv->pMemory         = NULL;
             }
 
             // Initialize output channels
@@ -466,6 +834,9 @@ namespace lsp
 
                 c->fDryPan[0]   = 0.0f;
                 c->fDryPan[1]   = 0.0f;
+                c->fOldDryPan[0]= 0.0f;
+                c->fOldDryPan[1]= 0.0f;
+                c->bEqReset     = true;
 
                 c->vOut         = NULL;
                 c->vBuffer      = reinterpret_cast<float *>(ptr);
@@ -563,6 +934,39 @@ namespace lsp
                 BIND_PORT(c->pHighCut);
                 BIND_PORT(c->pHighFreq);
             }
+
+            // Bind convolution engine ports
+            lsp_trace("Binding convolution engine ports");
+            SKIP_PORT("Engine settings visibility"); // Skip engine settings visibility port
+            BIND_PORT(pXFade);
+            BIND_PORT(pBankMem);
+            BIND_PORT(pLean);
+            BIND_PORT(pEmbed);
+            BIND_PORT(pReconfMem);
+            BIND_PORT(pWorkers);
+            BIND_PORT(pWorkerPrio);
+            BIND_PORT(pOffline);
+
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                convolver_t *c  = &vConvolvers[i];
+
+                BIND_PORT(c->pBank);
+                BIND_PORT(c->pMorphFile);
+                BIND_PORT(c->pMorph);
+            }
+
+            lsp_trace("Binding telemetry ports");
+            BIND_PORT(pDeadline);
+            BIND_PORT(pCpuLoad);
+            BIND_PORT(pMisses);
+            BIND_PORT(pReconfigLatency);
+            BIND_PORT(pMemory);
+            BIND_PORT(pMemPeak);
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                BIND_PORT(vFiles[i].pMemory);
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                BIND_PORT(vConvolvers[i].pMemory);
         }
 
         void impulse_reverb::destroy()
@@ -573,6 +977,9 @@ namespace lsp
 
         void impulse_reverb::do_destroy()
         {
+            // Stop using the worker pool
+            detach_executor();
+
             // Destroy files
             for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
                 destroy_file(&vFiles[i]);
@@ -585,8 +992,24 @@ namespace lsp
             for (size_t i=0; i<2; ++i)
                 destroy_channel(&vChannels[i]);
 
+            // Free recycled samples
+            sPool.destroy();
+
             // Delete all allocated data
             free_aligned(pData);
+
+            // Return the reserved memory to the process-wide budget
+            release_memory();
+        }
+
+        void impulse_reverb::activated()
+        {
+            // The convolvers keep the history of the signal and can not be cleared, so they are rebuilt
+            // and replaced without crossfade, the delay lines are cleared immediately
+            bFlush          = true;
+            ++nReconfigReq;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                vConvolvers[i].sDelay.clear();
         }
 
         void impulse_reverb::ui_activated()
@@ -596,6 +1019,12 @@ namespace lsp
                 vFiles[i].bSync     = true;
         }
 
+        void impulse_reverb::state_loaded()
+        {
+            // All files of the state become pending at once, load them as one batch
+            bRestore        = true;
+        }
+
         void impulse_reverb::update_settings()
         {
             const float out_gain    = pOutGain->value();
@@ -607,8 +1036,44 @@ namespace lsp
             const bool bypass       = pBypass->value() >= 0.5f;
             const float predelay    = pPredelay->value();
 
+            nXFade                  = dspu::millis_to_samples(fSampleRate, pXFade->value());
+            nBankMem                = pBankMem->value() * 0x100000;
+            fDeadline               = pDeadline->value() * 0.01f;
+            nReconfMem              = pReconfMem->value() * 0x100000;
+            nWorkers                = pWorkers->value();
+            nWorkerPrio             = pWorkerPrio->value();
+
+            // Check that memory-lean mode has changed
+            const bool lean         = pLean->value() >= 0.5f;
+            if (lean != bLean)
+            {
+                bLean                   = lean;
+                for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                    vFiles[i].bRender       = true;
+                ++nReconfigReq;
+            }
+
+            // Check that embedding of impulse response data has changed, re-load files to update state
+            const bool embed        = pEmbed->value() >= 0.5f;
+            if (embed != bEmbed)
+            {
+                bEmbed                  = embed;
+                for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                {
+                    af_descriptor_t *f      = &vFiles[i];
+                    if (f->nStatus == STATUS_OK)
+                        f->bReload              = true;
+                }
+            }
+
+            // Offline rendering does not care about responsiveness and uses bigger blocks and partitions
+            bOffline            = pOffline->value() >= 0.5f;
+            nBlockSize          = (bOffline) ? OFFLINE_BUF_SIZE : TMP_BUF_SIZE;
+
             // Check that FFT rank has changed
-            size_t rank         = get_fft_rank(pRank->value());
+            size_t rank         = (bOffline) ?
+                get_fft_rank(meta::impulse_reverb_metadata::FFT_RANK_65536) :
+                get_fft_rank(pRank->value());
             if (rank != nRank)
             {
                 nRank               = rank;
@@ -653,11 +1118,15 @@ namespace lsp
                 if (eq_mode != dspu::EQM_BYPASS)
                 {
                     dspu::filter_params_t fp;
-                    size_t band     = 0;
 
-                    // Set-up parametric equalizer
-                    while (band < meta::impulse_reverb_metadata::EQ_BANDS)
+                    // Set-up parametric equalizer, only bands with changed gain are updated
+                    for (size_t band=0; band < meta::impulse_reverb_metadata::EQ_BANDS; ++band)
                     {
+                        const float gain    = sc->pFreqGain[band]->value();
+                        if ((!c->bEqReset) && (gain == c->vEqGain[band]))
+                            continue;
+                        c->vEqGain[band]    = gain;
+
                         if (band == 0)
                         {
                             fp.fFreq        = band_freqs[band];
@@ -677,33 +1146,49 @@ namespace lsp
                             fp.nType        = dspu::FLT_MT_LRX_LADDERPASS;
                         }
 
-                        fp.fGain        = sc->pFreqGain[band]->value();
+                        fp.fGain        = gain;
                         fp.nSlope       = 2;
                         fp.fQuality     = 0.0f;
 
                         // Update filter parameters
-                        eq->set_params(band++, &fp);
+                        eq->set_params(band, &fp);
                     }
 
                     // Setup hi-pass filter
-                    size_t hp_slope = sc->pLowCut->value() * 2;
-                    fp.nType        = (hp_slope > 0) ? dspu::FLT_BT_BWC_HIPASS : dspu::FLT_NONE;
-                    fp.fFreq        = sc->pLowFreq->value();
-                    fp.fFreq2       = fp.fFreq;
-                    fp.fGain        = 1.0f;
-                    fp.nSlope       = hp_slope;
-                    fp.fQuality     = 0.0f;
-                    eq->set_params(band++, &fp);
+                    const size_t hp_slope   = sc->pLowCut->value() * 2;
+                    const float hp_freq     = sc->pLowFreq->value();
+                    if ((c->bEqReset) || (hp_slope != c->nLowSlope) || (hp_freq != c->fLowFreq))
+                    {
+                        c->nLowSlope    = hp_slope;
+                        c->fLowFreq     = hp_freq;
+
+                        fp.nType        = (hp_slope > 0) ? dspu::FLT_BT_BWC_HIPASS : dspu::FLT_NONE;
+                        fp.fFreq        = hp_freq;
+                        fp.fFreq2       = fp.fFreq;
+                        fp.fGain        = 1.0f;
+                        fp.nSlope       = hp_slope;
+                        fp.fQuality     = 0.0f;
+                        eq->set_params(meta::impulse_reverb_metadata::EQ_BANDS, &fp);
+                    }
 
                     // Setup low-pass filter
-                    size_t lp_slope = sc->pHighCut->value() * 2;
-                    fp.nType        = (lp_slope > 0) ? dspu::FLT_BT_BWC_LOPASS : dspu::FLT_NONE;
-                    fp.fFreq        = sc->pHighFreq->value();
-                    fp.fFreq2       = fp.fFreq;
-                    fp.fGain        = 1.0f;
-                    fp.nSlope       = lp_slope;
-                    fp.fQuality     = 0.0f;
-                    eq->set_params(band++, &fp);
+                    const size_t lp_slope   = sc->pHighCut->value() * 2;
+                    const float lp_freq     = sc->pHighFreq->value();
+                    if ((c->bEqReset) || (lp_slope != c->nHighSlope) || (lp_freq != c->fHighFreq))
+                    {
+                        c->nHighSlope   = lp_slope;
+                        c->fHighFreq    = lp_freq;
+
+                        fp.nType        = (lp_slope > 0) ? dspu::FLT_BT_BWC_LOPASS : dspu::FLT_NONE;
+                        fp.fFreq        = lp_freq;
+                        fp.fFreq2       = fp.fFreq;
+                        fp.fGain        = 1.0f;
+                        fp.nSlope       = lp_slope;
+                        fp.fQuality     = 0.0f;
+                        eq->set_params(meta::impulse_reverb_metadata::EQ_BANDS + 1, &fp);
+                    }
+
+                    c->bEqReset     = false;
                 }
             }
 
@@ -731,14 +1216,35 @@ namespace lsp
                 // Set pre-delay
                 cv->sDelay.set_delay(dspu::millis_to_samples(fSampleRate, predelay + cv->pPredelay->value()));
 
-                // Analyze source
-                size_t file         = (cv->pMute->value() < 0.5f) ? cv->pFile->value() : 0;
+                // Analyze source. In IR bank mode the source file selects one of prepared convolvers and the
+                // active convolver is kept until the configurator delivers the convolvers of the new mode.
+                dspu::Convolver *old= active_convolver(cv);
+                const bool mute     = cv->pMute->value() >= 0.5f;
+                const bool bank     = cv->pBank->value() >= 0.5f;
+                size_t file         = cv->pFile->value();
                 size_t track        = cv->pTrack->value();
-                if ((file != cv->nFile) || (track != cv->nTrack))
-                {
-                    cv->nFile           = file;
-                    cv->nTrack          = track;
+                if ((track != cv->nTrack) || (bank != cv->bBankReq) || ((!bank) && (file != cv->nFile)))
                     ++nReconfigReq;
+                cv->bMute           = mute;
+                cv->bBankReq        = bank;
+                cv->nFile           = file;
+                cv->nTrack          = track;
+                if (old != active_convolver(cv))
+                {
+                    mark_stale(cv, old);
+                    start_crossfade(&cv->sFade, old, active_convolver(cv));
+                }
+
+                // Analyze morphing: the convolver is built from the blend of impulse responses of both
+                // files and is rebuilt only when the morphing parameters stay unchanged for a while
+                const size_t morph_file = cv->pMorphFile->value();
+                const bool morphing = (!bank) && (file > 0) && (morph_file > 0) && (morph_file != file);
+                const float morph   = (morphing) ? cv->pMorph->value() * 0.01f : 0.0f;
+                if ((morph_file != cv->nMorphFile) || (morph != cv->fMorph))
+                {
+                    cv->nMorphFile      = morph_file;
+                    cv->fMorph          = morph;
+                    cv->nMorphHold      = lsp_max(dspu::millis_to_samples(fSampleRate, MORPH_SETTLE), size_t(1));
                 }
             }
 
@@ -747,6 +1253,14 @@ namespace lsp
             {
                 af_descriptor_t *f  = &vFiles[i];
 
+                // Check that the file needs to be re-loaded with more tracks or the embedded data lacks them
+                f->nTracks          = required_tracks(i);
+                if ((f->nStatus == STATUS_OK) && (f->sLoader.idle()))
+                {
+                    if ((f->nTracks & (~f->nLoadMask)) || ((bEmbed) && (f->nTracks & (~f->nEmbedMask))))
+                        f->bReload          = true;
+                }
+
                 // Check that file parameters have changed
                 float pitch         = f->pPitch->value();
                 float head_cut      = f->pHeadCut->value();
@@ -769,6 +1283,10 @@ namespace lsp
                     f->bReverse         = reverse;
                     f->bRender          = true;
                     nReconfigReq        ++;
+
+                    // The data restored from the state or stored into it may lack samples required by new settings
+                    if ((f->nStatus == STATUS_OK) && (f->sLoader.idle()) && (!embed_covers(f)))
+                        f->bReload          = true;
                 }
 
                 // Listen button pressed?
@@ -777,6 +1295,26 @@ namespace lsp
                 if (f->pStop != NULL)
                     f->sStop.submit(f->pStop->value());
             }
+
+            // Do not ramp gains after the plugin has been just initialized
+            if (bSnapGains)
+            {
+                bSnapGains          = false;
+                for (size_t i=0; i<2; ++i)
+                {
+                    channel_t *c        = &vChannels[i];
+                    c->fOldDryPan[0]    = c->fDryPan[0];
+                    c->fOldDryPan[1]    = c->fDryPan[1];
+                }
+                for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                {
+                    convolver_t *cv     = &vConvolvers[i];
+                    cv->fOldPanIn[0]    = cv->fPanIn[0];
+                    cv->fOldPanIn[1]    = cv->fPanIn[1];
+                    cv->fOldPanOut[0]   = cv->fPanOut[0];
+                    cv->fOldPanOut[1]   = cv->fPanOut[1];
+                }
+            }
         }
 
         void impulse_reverb::update_sample_rate(long sr)
@@ -790,9 +1328,138 @@ namespace lsp
                 vChannels[i].sEqualizer.set_sample_rate(sr);
             }
 
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                vFiles[i].bRender   = true;
+
             ++nReconfigReq;
         }
 
+        size_t impulse_reverb::required_tracks(size_t file) const
+        {
+            size_t mask         = 0;
+            const size_t id     = file + 1;
+
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                const convolver_t *c    = &vConvolvers[i];
+                if ((c->bBankReq) || (c->nFile == id) || (c->nMorphFile == id))
+                    mask               |= size_t(1) << c->nTrack;
+            }
+
+            return mask;
+        }
+
+        ssize_t impulse_reverb::track_index(const af_descriptor_t *af, size_t track)
+        {
+            // Only selected tracks are loaded, compute the index of the track in the loaded sample
+            const size_t mask   = af->nLoadMask;
+            if (!(mask & (size_t(1) << track)))
+                return -1;
+
+            ssize_t index       = 0;
+            for (size_t i=0; i<track; ++i)
+                if (mask & (size_t(1) << i))
+                    ++index;
+
+            return index;
+        }
+
+        status_t impulse_reverb::configure_executor()
+        {
+            const size_t workers    = nWorkers;
+            const size_t priority   = nWorkerPrio;
+            nPoolWorkers            = workers;
+            nPoolPrio               = priority;
+
+            // Return to the host executor
+            if (workers <= 0)
+            {
+                detach_executor();
+                return STATUS_OK;
+            }
+
+            // Attach to the worker pool
+            if (pPool == NULL)
+            {
+                if ((pPool = WorkerPool::acquire()) == NULL)
+                    return STATUS_NO_MEM;
+                pPool->attach(&sQueue);
+            }
+            pPool->configure(&sQueue, workers, worker_priority_t(priority));
+
+            return STATUS_OK;
+        }
+
+        void impulse_reverb::detach_executor()
+        {
+            if (pPool == NULL)
+                return;
+
+            pPool->detach(&sQueue);
+            pPool->release();
+            pPool                   = NULL;
+        }
+
+        void impulse_reverb::process_restore_events(size_t samples)
+        {
+            // Start the batch: the files are loaded concurrently and configured once after all of them
+            if (bRestore)
+            {
+                bRestore        = false;
+                bRestoreBatch   = true;
+                bRestoreCheck   = true;
+                nRestoreHold    = dspu::millis_to_samples(fSampleRate, RESTORE_HOLD);
+                perf::start(&sRestoreTime);
+                lsp_trace("Started loading of the restored state");
+            }
+            else if (bRestoreCheck)
+            {
+                // Do not wait for other files if the first block of the restored state did not request any
+                bRestoreCheck   = false;
+                if ((!has_active_loading_tasks()) && (!has_pending_files()))
+                    nRestoreHold    = 0;
+            }
+
+            nRestoreHold   -= lsp_min(nRestoreHold, samples);
+        }
+
+        void impulse_reverb::process_morph_events(size_t samples)
+        {
+            // Request the rebuild of the convolver when the morphing has settled
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                convolver_t *c      = &vConvolvers[i];
+                if (c->nMorphHold <= 0)
+                    continue;
+
+                c->nMorphHold      -= lsp_min(c->nMorphHold, samples);
+                if (c->nMorphHold <= 0)
+                    ++c->nBuildReq;
+            }
+        }
+
+        void impulse_reverb::process_executor_tasks()
+        {
+            // Switch to the configured executor
+            if (sExecutorTask.completed())
+            {
+                pExecutor       = (pPool != NULL) ? &sQueue : pHostExecutor;
+                lsp_trace("Executor = %p", pExecutor);
+                sExecutorTask.reset();
+            }
+
+            if ((!sExecutorTask.idle()) || ((nWorkers == nPoolWorkers) && (nWorkerPrio == nPoolPrio)))
+                return;
+
+            // The queue can be detached only when it does not contain tasks
+            if ((has_active_loading_tasks()) || (!sConfigurator.idle()) || (!sGCTask.idle()) || (has_active_convolver_tasks()))
+                return;
+
+            // Submit tasks to the host executor while the worker pool is being configured
+            pExecutor       = pHostExecutor;
+            pHostExecutor->submit(&sExecutorTask);
+        }
+
         bool impulse_reverb::has_active_loading_tasks()
         {
             for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
@@ -801,10 +1468,79 @@ namespace lsp
             return false;
         }
 
+        bool impulse_reverb::has_active_convolver_tasks()
+        {
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS - 1; ++i)
+            {
+                const ConvolverTask *t  = &vConvTasks[i];
+                if ((!t->idle()) && (!t->completed()))
+                    return true;
+            }
+            return false;
+        }
+
+        bool impulse_reverb::has_active_crossfades()
+        {
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                if (vConvolvers[i].sFade.nLen > 0)
+                    return true;
+            return false;
+        }
+
+        bool impulse_reverb::has_build_requests()
+        {
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                if (vConvolvers[i].nBuildReq != vConvolvers[i].nBuildResp)
+                    return true;
+            return false;
+        }
+
+        bool impulse_reverb::has_morph_holds()
+        {
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                if (vConvolvers[i].nMorphHold > 0)
+                    return true;
+            return false;
+        }
+
+        bool impulse_reverb::has_preview_requests()
+        {
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+                if (vFiles[i].bPreview)
+                    return true;
+            return false;
+        }
+
+        bool impulse_reverb::settled()
+        {
+            if ((bRestore) || (bRestoreBatch) || (nRestoreHold > 0) || (bDeferPending) || (has_build_requests()))
+                return false;
+            if ((has_morph_holds()) || (nReconfigReq != nReconfigResp) || (!sConfigurator.idle()))
+                return false;
+            if ((has_active_loading_tasks()) || (has_active_crossfades()) || (has_pending_files()))
+                return false;
+
+            return true;
+        }
+
+        bool impulse_reverb::has_pending_files()
+        {
+            // Files that have been requested but not submitted for loading yet
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                af_descriptor_t *f      = &vFiles[i];
+                plug::path_t *path      = (f->pFile != NULL) ? f->pFile->buffer<plug::path_t>() : NULL;
+                if ((f->bReload) || ((path != NULL) && (path->pending())))
+                    return true;
+            }
+            return false;
+        }
+
         void impulse_reverb::process_loading_tasks()
         {
-            // Do nothing with loading while configurator is active
-            if (!sConfigurator.idle())
+            // Do nothing with loading while configurator is active, do not submit loaders to the host
+            // executor while the instance is being attached to the worker pool
+            if ((!sConfigurator.idle()) || (!sExecutorTask.idle()))
                 return;
 
             for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
@@ -825,18 +1561,32 @@ namespace lsp
                     if (pExecutor->submit(&f->sLoader))
                     {
                         lsp_trace("Successfully submitted load task");
+                        if (bRestoreBatch)
+                            nRestoreHold    = dspu::millis_to_samples(fSampleRate, RESTORE_HOLD);
                         f->nStatus      = STATUS_LOADING;
+                        f->bReload      = false;
                         path->accept();
                     }
                 }
-                else if ((path->accepted()) && (f->sLoader.completed())) // The reload request has been processed
+                else if ((f->bReload) && (f->sLoader.idle())) // Convolvers require tracks that have not been loaded
+                {
+                    if (pExecutor->submit(&f->sLoader))
+                    {
+                        lsp_trace("Successfully submitted re-load task");
+                        f->nStatus      = STATUS_LOADING;
+                        f->bReload      = false;
+                    }
+                }
+                else if (f->sLoader.completed()) // The reload request has been processed
                 {
                     // Update file status and set re-rendering flag
                     f->nStatus      = f->sLoader.code();
+                    f->bRender      = true;
                     ++nReconfigReq;
 
                     // Now we surely can commit changes and reset task state
-                    path->commit();
+                    if (path->accepted())
+                        path->commit();
                     f->sLoader.reset();
                 }
             }
@@ -844,32 +1594,72 @@ namespace lsp
 
         void impulse_reverb::process_configuration_tasks()
         {
-            // Do nothing if at least one loader is active
-            if (has_active_loading_tasks())
+            // Remember the time of the reconfiguration request
+            if ((nReconfigReq != nReconfigResp) && (nReqTime == 0))
+                nReqTime        = perf::now();
+
+            // Do nothing if at least one loader is active or more files of the restored state are expected
+            if ((has_active_loading_tasks()) || (nRestoreHold > 0))
                 return;
 
-            if ((nReconfigReq != nReconfigResp) && (sConfigurator.idle()))
+            if (((nReconfigReq != nReconfigResp) || (bDeferPending) || (has_build_requests()) || (has_preview_requests())) &&
+                (sConfigurator.idle()))
             {
+                // Do not destroy convolvers that are still being faded out
+                if (has_active_crossfades())
+                    return;
+
+                // Wait until other instances finish their reconfiguration if the memory budget is exceeded
+                if (!reserve_memory())
+                    return;
+
                 // Try to submit task
                 if (pExecutor->submit(&sConfigurator))
                 {
+                    bDeferPass      = nReconfigReq == nReconfigResp;
+                    bFlushPass      = bFlush;
+                    bFlush          = false;
+                    bRestoreConfig  = bRestoreBatch;
+                    bRestoreBatch   = false;
+                    bDeferPending   = false;
                     nReconfigResp   = nReconfigReq;
+                    nSubmitTime     = nReqTime;
+                    nReqTime        = 0;
                     lsp_trace("Successfully submitted configuration task");
                 }
+                else
+                    release_memory();
             }
             else if (sConfigurator.completed())
             {
-                // Update samples
+                // Update samples, the partial pass does not render them and only creates the requested previews
                 for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
                 {
                     af_descriptor_t *f = &vFiles[i];
+                    if ((bDeferPass) && (!f->bPreviewDone))
+                        continue;
 
-                    // Bind sample player for each output channel
-                    for (size_t j=0; j<2; ++j)
+                    // Bind sample player for each output channel, the partial pass keeps the bound sample
+                    // if the preview could not be created
+                    if ((!bDeferPass) || (f->pProcessed != NULL))
                     {
-                        channel_t *c = &vChannels[j];
-                        c->sPlayer.bind(i, f->pProcessed);
+                        for (size_t j=0; j<2; ++j)
+                        {
+                            channel_t *c = &vChannels[j];
+                            c->sPlayer.bind(i, f->pProcessed);
+                        }
+                        f->nPlayMem     = sample_memory(f->pProcessed);
+                    }
+
+                    // Drop the listen request if the requested preview has nothing to play
+                    if (f->bPreviewDone)
+                    {
+                        if (f->pProcessed == NULL)
+                            f->sListen.commit();
+                        f->bPreview     = false;
+                        f->bPreviewDone = false;
                     }
+
                     f->pProcessed   = NULL;
                     f->bSync        = true;
                 }
@@ -878,12 +1668,151 @@ namespace lsp
                 for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
                 {
                     convolver_t *c      = &vConvolvers[i];
-                    lsp::swap(c->pCurr, c->pSwap);
+                    if (c->bKeep)
+                        continue;
+                    if (c->bDefer)
+                        bDeferPending       = true;
+
+                    dspu::Convolver *old= active_convolver(c);
+                    if (c->bRebuild)
+                    {
+                        // Only the rebuilt convolvers replace the stale ones and the one of the settled morphing
+                        if ((c->pSwap != NULL) || (c->bDefer))
+                        {
+                            lsp::swap(c->pCurr, c->pSwap);
+                            lsp::swap(c->nCurrMem, c->nSwapMem);
+                            c->bStale           = false;
+                        }
+                        for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                        {
+                            if (c->vBankSwap[j] == NULL)
+                                continue;
+                            lsp::swap(c->vBank[j], c->vBankSwap[j]);
+                            lsp::swap(c->vBankMem[j], c->vBankSwapMem[j]);
+                            c->vStale[j]        = false;
+                        }
+                        c->bRebuild         = false;
+                    }
+                    else
+                    {
+                        lsp::swap(c->pCurr, c->pSwap);
+                        lsp::swap(c->nCurrMem, c->nSwapMem);
+                        for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                        {
+                            lsp::swap(c->vBank[j], c->vBankSwap[j]);
+                            lsp::swap(c->vBankMem[j], c->vBankSwapMem[j]);
+                            c->vStale[j]        = false;
+                        }
+                        c->bBank            = c->bBankSwap;
+                        c->bStale           = false;
+                    }
+
+                    // The old convolvers contain the signal of the previous activation on flush
+                    if (bFlushPass)
+                        start_crossfade(&c->sFade, NULL, NULL);
+                    else
+                        start_crossfade(&c->sFade, old, active_convolver(c));
                 }
+                bFlushPass      = false;
 
                 // Reset configurator
                 sConfigurator.reset();
+                release_memory();
+                if (nSubmitTime != 0)
+                {
+                    perf::commit(&sReconfigLatency, perf::now() - nSubmitTime);
+                    nSubmitTime     = 0;
+                }
+                if (bRestoreConfig)
+                {
+                    perf::stop(&sRestoreTime);
+                    bRestoreConfig  = false;
+                }
+            }
+        }
+
+        size_t impulse_reverb::reconfig_memory() const
+        {
+            // Estimate the length of impulse response rendered from each file with the current settings
+            size_t lengths[meta::impulse_reverb_metadata::FILES];
+            size_t size         = 0;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                const af_descriptor_t *f    = &vFiles[i];
+                const dspu::Sample *s       = f->pOriginal;
+                lengths[i]          = 0;
+                if (f->nStatus != STATUS_OK)
+                    continue;
+
+                // The memory-lean mode drops the original sample, use the duration of the last rendering then
+                const size_t srate_dst  = fSampleRate * dspu::semitones_to_frequency_shift(-f->fPitch);
+                const size_t cut        = dspu::millis_to_samples(fSampleRate, f->fHeadCut + f->fTailCut);
+                const size_t total      = ((s != NULL) && (s->sample_rate() > 0)) ?
+                    (s->samples() * srate_dst) / s->sample_rate() :
+                    dspu::seconds_to_samples(fSampleRate, f->fDuration);
+                const size_t channels   = (s != NULL) ?
+                    lsp_min(s->channels(), meta::impulse_reverb_metadata::TRACKS_MAX) : f->nChannels;
+                lengths[i]          = (total > cut) ? total - cut : 0;
+
+                // The memory-lean mode renders only files with changed parameters and re-reads the original sample
+                if ((bLean) && (!f->bRender))
+                    continue;
+                size               += channels * lengths[i] * sizeof(float);
+                if (s == NULL)
+                    size               += channels * total * sizeof(float);
+                if (((s == NULL) || (s->sample_rate() != srate_dst)) && (f->nResampleRate != srate_dst))
+                    size               += channels * total * sizeof(float);
+            }
+
+            // Each channel builds the convolver of the selected file blended with the morph target, or the IR bank
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                const convolver_t *c        = &vConvolvers[i];
+                if (c->bBankReq)
+                {
+                    for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                        size               += convolver_size(lengths[j], nRank);
+                    continue;
+                }
+
+                const size_t file   = c->nFile;
+                const size_t target = c->nMorphFile;
+                if ((file <= 0) || (file > meta::impulse_reverb_metadata::FILES))
+                    continue;
+                const bool morph    = (c->fMorph > 0.0f) && (target > 0) && (target <= meta::impulse_reverb_metadata::FILES);
+                size               += convolver_size((morph) ? lsp_max(lengths[file - 1], lengths[target - 1]) : lengths[file - 1], nRank);
+            }
+
+            return size;
+        }
+
+        bool impulse_reverb::reserve_memory()
+        {
+            // Reserve the memory which will be allocated by the reconfiguration in addition to the held data
+            const atomic_t size     = atomic_t(reconfig_memory() >> 10);
+            const atomic_t limit    = atomic_t(nReconfMem >> 10);
+
+            while (true)
+            {
+                // Always allow reconfiguration if there are no other reservations to avoid starvation
+                const atomic_t used     = nGlobalReserved;
+                if ((used > 0) && (used + size > limit))
+                    return false;
+                if (atomic_cas(&nGlobalReserved, used, used + size))
+                    break;
             }
+
+            nReserved       = size;
+            return true;
+        }
+
+        void impulse_reverb::release_memory()
+        {
+            if (nReserved <= 0)
+                return;
+
+            atomic_add(&nGlobalReserved, -nReserved);
+            nReserved       = 0;
         }
 
         void impulse_reverb::process_gc_events()
@@ -917,22 +1846,37 @@ namespace lsp
                 // Need to start audio preview playback?
                 if (f->sListen.pending())
                 {
-                    lsp_trace("Submitted listen toggle");
                     dspu::Sample *s = vChannels[0].sPlayer.get(i);
-                    const size_t n_c = (s != NULL) ? s->channels() : 0;
-                    if (n_c > 0)
+
+                    // In memory-lean mode the preview sample is copied from the rendered sample on demand by
+                    // the partial configuration pass, keep the listen request pending until the sample becomes
+                    // bound to the player
+                    if ((s == NULL) && (bLean) && (f->nStatus == STATUS_OK))
                     {
-                        for (size_t j=0; j<2; ++j)
+                        if (!f->bPreview)
                         {
-                            channel_t *c = &vChannels[j];
-                            ps.set_channel(i, j % n_c);
-                            ps.set_playback(0, 0, GAIN_AMP_0_DB);
-
-                            c->vPlaybacks[i].cancel(fadeout, 0);
-                            c->vPlaybacks[i] = c->sPlayer.play(&ps);
+                            lsp_trace("Requested preview sample for file %d", int(i));
+                            f->bPreview     = true;
+                        }
+                    }
+                    else
+                    {
+                        lsp_trace("Submitted listen toggle");
+                        const size_t n_c = (s != NULL) ? s->channels() : 0;
+                        if (n_c > 0)
+                        {
+                            for (size_t j=0; j<2; ++j)
+                            {
+                                channel_t *c = &vChannels[j];
+                                ps.set_channel(i, j % n_c);
+                                ps.set_playback(0, 0, GAIN_AMP_0_DB);
+
+                                c->vPlaybacks[i].cancel(fadeout, 0);
+                                c->vPlaybacks[i] = c->sPlayer.play(&ps);
+                            }
                         }
+                        f->sListen.commit();
                     }
-                    f->sListen.commit();
                 }
 
                 // Need to cancel audio preview playback?
@@ -948,20 +1892,187 @@ namespace lsp
             }
         }
 
-        void impulse_reverb::perform_convolution(size_t samples)
+        void impulse_reverb::start_crossfade(xfade_t *xf, dspu::Convolver *old, dspu::Convolver *curr)
         {
-            // Get pointers to data channels
-            for (size_t i=0; i<nInputs; ++i)
-                vInputs[i].vIn      = vInputs[i].pIn->buffer<float>();
+            if ((nXFade <= 0) || (old == curr))
+            {
+                xf->pOld        = NULL;
+                xf->nPos        = 0;
+                xf->nLen        = 0;
+                return;
+            }
 
-            for (size_t i=0; i<2; ++i)
-                vChannels[i].vOut   = vChannels[i].pOut->buffer<float>();
+            xf->pOld        = old;
+            xf->nPos        = 0;
+            xf->nLen        = nXFade;
+        }
+
+        void impulse_reverb::process_crossfade(xfade_t *xf, dspu::Convolver *cv, float *dst, const float *src, float *temp, size_t samples)
+        {
+            // The old convolver is processed only within the crossfade window
+            const size_t fade   = lsp_min(samples, xf->nLen - xf->nPos);
+            const float k       = 1.0f / float(xf->nLen);
+            const float k1      = float(xf->nPos) * k;
+            const float k2      = float(xf->nPos + fade) * k;
+
+            if (xf->pOld != NULL)
+                xf->pOld->process(temp, src, fade);
+            else
+                dsp::fill_zero(temp, fade);
+
+            if (cv != NULL)
+                cv->process(dst, src, samples);
+            else
+                dsp::fill_zero(dst, samples);
+
+            // Fade-in the new convolver and fade-out the old one
+            dsp::lramp1(dst, k1, k2, fade);
+            dsp::lramp_add2(dst, temp, 1.0f - k1, 1.0f - k2, fade);
+
+            // Check that crossfade is complete
+            xf->nPos           += fade;
+            if (xf->nPos >= xf->nLen)
+            {
+                xf->pOld            = NULL;
+                xf->nPos            = 0;
+                xf->nLen            = 0;
+            }
+        }
+
+        void impulse_reverb::process_convolver(xfade_t *xf, dspu::Convolver *cv, float *dst, const float *src, float *temp, size_t samples)
+        {
+            if (xf->nLen > 0)
+                process_crossfade(xf, cv, dst, src, temp, samples);
+            else if (cv != NULL)
+                cv->process(dst, src, samples);
+            else
+                dsp::fill_zero(dst, samples);
+        }
+
+        impulse_reverb::miss_cause_t impulse_reverb::miss_cause(const perf::timing_t *stages)
+        {
+            // Attribute the miss to the stage which took the most time in the last block
+            const uint64_t conv     = stages[STG_CONVOLUTION].nLast;
+            const uint64_t eq       = stages[STG_EQUALIZER].nLast;
+            const uint64_t swap     = stages[STG_SWAP].nLast;
+            const uint64_t other    = stages[STG_PROCESS].nLast - lsp_min(stages[STG_PROCESS].nLast, conv + eq + swap);
+
+            if ((conv >= eq) && (conv >= swap) && (conv >= other))
+                return MISS_CONVOLUTION;
+            if ((eq >= swap) && (eq >= other))
+                return MISS_EQUALIZER;
+            return (swap >= other) ? MISS_SWAP : MISS_OTHER;
+        }
+
+        void impulse_reverb::mark_stage(uint64_t *spent, size_t stage, uint64_t *ts)
+        {
+            const uint64_t time = perf::now();
+            spent[stage]       += time - *ts;
+            *ts                 = time;
+        }
+
+        void impulse_reverb::ramp_copy(float *dst, const float *src, float *k_old, float k_new, size_t count)
+        {
+            // Linearly interpolate gain from the previous value within the block
+            if (*k_old == k_new)
+                dsp::mul_k3(dst, src, k_new, count);
+            else
+            {
+                dsp::lramp2(dst, src, *k_old, k_new, count);
+                *k_old      = k_new;
+            }
+        }
+
+        void impulse_reverb::ramp_add(float *dst, const float *src, float *k_old, float k_new, size_t count)
+        {
+            if (*k_old == k_new)
+                dsp::fmadd_k3(dst, src, k_new, count);
+            else
+            {
+                dsp::lramp_add2(dst, src, *k_old, k_new, count);
+                *k_old      = k_new;
+            }
+        }
+
+        void impulse_reverb::convolve(convolver_t *c, size_t samples)
+        {
+            // Prepare input buffer: apply panning if present
+            if (nInputs == 1)
+                dsp::copy(c->vBuffer, vInputs[0].vIn, samples);
+            else if ((c->fOldPanIn[0] == c->fPanIn[0]) && (c->fOldPanIn[1] == c->fPanIn[1]))
+                dsp::mix_copy2(c->vBuffer, vInputs[0].vIn, vInputs[1].vIn, c->fPanIn[0], c->fPanIn[1], samples);
+            else
+            {
+                ramp_copy(c->vBuffer, vInputs[0].vIn, &c->fOldPanIn[0], c->fPanIn[0], samples);
+                ramp_add(c->vBuffer, vInputs[1].vIn, &c->fOldPanIn[1], c->fPanIn[1], samples);
+            }
+
+            // Do processing
+            process_convolver(&c->sFade, active_convolver(c), c->vBuffer, c->vBuffer, c->vTemp, samples);
+            c->sDelay.process(c->vBuffer, c->vBuffer, samples);
+        }
+
+        void impulse_reverb::run_convolvers()
+        {
+            // Claim convolvers one by one, so the calling thread processes convolvers which have not
+            // been taken by workers and does not depend on the availability of the worker pool
+            while (true)
+            {
+                const uatomic_t index   = nConvClaim;
+                if (index >= meta::impulse_reverb_metadata::CONVOLVERS)
+                    break;
+                if (!atomic_cas(&nConvClaim, index, index + 1))
+                    continue;
+
+                convolve(&vConvolvers[index], nConvSamples);
+            }
+        }
+
+        void impulse_reverb::process_convolvers(size_t samples)
+        {
+            // Workers can see the reset index only after the block parameters have been updated
+            nConvSamples        = samples;
+            atomic_swap(&nConvClaim, 0);
+
+            // Offline rendering does not need real-time guarantees and shares convolvers with the worker pool
+            const bool shared   = (bOffline) && (pExecutor == &sQueue);
+            if (shared)
+            {
+                for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS - 1; ++i)
+                    sQueue.submit(&vConvTasks[i]);
+            }
+
+            run_convolvers();
+            if (!shared)
+                return;
+
+            // The calling thread has processed all convolvers not claimed by workers, so the tasks which have
+            // not been started are withdrawn. Wait only for the started ones, all tasks are idle after the block.
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS - 1; ++i)
+            {
+                ConvolverTask *t    = &vConvTasks[i];
+                if (sQueue.withdraw(t))
+                    continue;
+                while ((!t->idle()) && (!t->completed()))
+                    ipc::Thread::yield();
+                if (t->completed())
+                    t->reset();
+            }
+        }
+
+        void impulse_reverb::perform_convolution(size_t samples)
+        {
+            // Time spent on each stage
+            uint64_t spent[STG_SWAP];
+            for (size_t i=0; i<STG_SWAP; ++i)
+                spent[i]            = 0;
+            uint64_t ts         = perf::now();
 
             // Process samples
             while (samples > 0)
             {
                 // Determine number of samples to process
-                size_t to_do        = TMP_BUF_SIZE;
+                size_t to_do        = nBlockSize;
                 if (to_do > samples)
                     to_do               = samples;
 
@@ -969,28 +2080,15 @@ namespace lsp
                 dsp::fill_zero(vChannels[0].vBuffer, to_do);
                 dsp::fill_zero(vChannels[1].vBuffer, to_do);
 
-                // Call convolvers
+                // Call convolvers and apply processed signal to output channels
+                process_convolvers(to_do);
                 for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
                 {
                     convolver_t *c      = &vConvolvers[i];
-
-                    // Prepare input buffer: apply panning if present
-                    if (nInputs == 1)
-                        dsp::copy(c->vBuffer, vInputs[0].vIn, to_do);
-                    else
-                        dsp::mix_copy2(c->vBuffer, vInputs[0].vIn, vInputs[1].vIn, c->fPanIn[0], c->fPanIn[1], to_do);
-
-                    // Do processing
-                    if (c->pCurr != NULL)
-                        c->pCurr->process(c->vBuffer, c->vBuffer, to_do);
-                    else
-                        dsp::fill_zero(c->vBuffer, to_do);
-                    c->sDelay.process(c->vBuffer, c->vBuffer, to_do);
-
-                    // Apply processed signal to output channels
-                    dsp::fmadd_k3(vChannels[0].vBuffer, c->vBuffer, c->fPanOut[0], to_do);
-                    dsp::fmadd_k3(vChannels[1].vBuffer, c->vBuffer, c->fPanOut[1], to_do);
+                    ramp_add(vChannels[0].vBuffer, c->vBuffer, &c->fOldPanOut[0], c->fPanOut[0], to_do);
+                    ramp_add(vChannels[1].vBuffer, c->vBuffer, &c->fOldPanOut[1], c->fPanOut[1], to_do);
                 }
+                mark_stage(spent, STG_CONVOLUTION, &ts);
 
                 // Now apply equalization, bypass control and players
                 for (size_t i=0; i<2; ++i)
@@ -999,16 +2097,24 @@ namespace lsp
 
                     // Apply equalization
                     c->sEqualizer.process(c->vBuffer, c->vBuffer, to_do);
+                    mark_stage(spent, STG_EQUALIZER, &ts);
 
                     // Pass dry sound to output channels
                     if (nInputs == 1)
-                        dsp::fmadd_k3(c->vBuffer, vInputs[0].vIn, c->fDryPan[0], to_do);
-                    else
+                        ramp_add(c->vBuffer, vInputs[0].vIn, &c->fOldDryPan[0], c->fDryPan[0], to_do);
+                    else if ((c->fOldDryPan[0] == c->fDryPan[0]) && (c->fOldDryPan[1] == c->fDryPan[1]))
                         dsp::mix_add2(c->vBuffer, vInputs[0].vIn, vInputs[1].vIn, c->fDryPan[0], c->fDryPan[1], to_do);
+                    else
+                    {
+                        ramp_add(c->vBuffer, vInputs[0].vIn, &c->fOldDryPan[0], c->fDryPan[0], to_do);
+                        ramp_add(c->vBuffer, vInputs[1].vIn, &c->fOldDryPan[1], c->fDryPan[1], to_do);
+                    }
 
                     // Apply player and bypass
                     c->sPlayer.process(c->vBuffer, c->vBuffer, to_do);
+                    mark_stage(spent, STG_PLAYER, &ts);
                     c->sBypass.process(c->vOut, vInputs[i%nInputs].vIn, c->vBuffer, to_do);
+                    mark_stage(spent, STG_BYPASS, &ts);
 
                     // Update pointers
                     c->vOut            += to_do;
@@ -1019,6 +2125,11 @@ namespace lsp
 
                 samples            -= to_do;
             }
+
+            // Commit the time spent on each stage once per call, so the last value of the stage
+            // covers the whole block, the deadline miss analysis relies on it
+            for (size_t i=0; i<STG_SWAP; ++i)
+                perf::commit(&vStages[i], spent[i]);
         }
 
         void impulse_reverb::output_parameters()
@@ -1027,13 +2138,31 @@ namespace lsp
             {
                 // Output information about the convolver
                 convolver_t *c          = &vConvolvers[i];
-                c->pActivity->set_value((c->pCurr != NULL) ? 1.0f : 0.0f);
+                c->pActivity->set_value((active_convolver(c) != NULL) ? 1.0f : 0.0f);
             }
 
-            // Do not output meshes until configuration finishes
+            // Do not output meshes and memory usage until configuration finishes
             if (!sConfigurator.idle())
                 return;
 
+            size_t total            = 0;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                const af_descriptor_t *af   = &vFiles[i];
+                const size_t size           = af->nMemory + af->nPlayMem;
+                af->pMemory->set_value(float(size) / float(0x100000));
+                total                      += size;
+            }
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                const convolver_t *c        = &vConvolvers[i];
+                const size_t size           = convolver_memory(c);
+                c->pMemory->set_value(float(size) / float(0x100000));
+                total                      += size;
+            }
+            pMemory->set_value(float(total) / float(0x100000));
+            pMemPeak->set_value(float(lsp_max(nMemPeak, total)) / float(0x100000));
+
             for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
             {
                 af_descriptor_t *af     = &vFiles[i];
@@ -1041,11 +2170,8 @@ namespace lsp
                     continue;
 
                 // Output information about the file
-                dspu::Sample *active    = vChannels[0].sPlayer.get(i);
-                size_t channels         = (active != NULL) ? active->channels() : 0;
-                channels                = lsp_min(channels, 2u);
-
-                const float duration    = (af->pOriginal != NULL) ? af->fDuration : 0.0f;
+                const size_t channels   = lsp_min(af->nChannels, 2u);
+                const float duration    = (af->nStatus == STATUS_OK) ? af->fDuration : 0.0f;
                 af->pLength->set_value(duration * 1000.0f);
                 af->pStatus->set_value(af->nStatus);
 
@@ -1069,12 +2195,48 @@ namespace lsp
 
         void impulse_reverb::process(size_t samples)
         {
+            IR_RT_SCOPE;
+
+            const uint64_t started  = perf::now();
+
+            process_executor_tasks();
+            process_restore_events(samples);
+            process_morph_events(samples);
             process_loading_tasks();
+            perf::start(&vStages[STG_SWAP]);
             process_configuration_tasks();
+            perf::stop(&vStages[STG_SWAP]);
             process_gc_events();
             process_listen_events();
+
+            // Get pointers to data channels
+            for (size_t i=0; i<nInputs; ++i)
+                vInputs[i].vIn      = vInputs[i].pIn->buffer<float>();
+            for (size_t i=0; i<2; ++i)
+                vChannels[i].vOut   = vChannels[i].pOut->buffer<float>();
+
             perform_convolution(samples);
             output_parameters();
+
+            // Update CPU load
+            const uint64_t elapsed  = perf::now() - started;
+            perf::commit(&vStages[STG_PROCESS], elapsed);
+            if (samples > 0)
+            {
+                const float budget      = (samples * 1e+9f) / fSampleRate;
+                const float load        = (elapsed * 100.0f) / budget;
+                fCpuLoad               += (load - fCpuLoad) * CPU_LOAD_SMOOTH;
+
+                // Check that the block has met the deadline
+                if (elapsed > budget * fDeadline)
+                {
+                    ++nMisses;
+                    ++vMissCause[miss_cause(vStages)];
+                }
+            }
+            pCpuLoad->set_value(fCpuLoad);
+            pMisses->set_value(nMisses);
+            pReconfigLatency->set_value(sReconfigLatency.nLast * 1e-6f);
         }
 
         status_t impulse_reverb::load(af_descriptor_t *descr)
@@ -1085,6 +2247,8 @@ namespace lsp
 
             // Destroy previously loaded sample
             destroy_sample(descr->pOriginal);
+            destroy_sample(descr->pResampled);
+            ++descr->nSourceGen;
 
             // Check state
             if (descr->pFile == NULL)
@@ -1098,7 +2262,10 @@ namespace lsp
             // Get file name
             const char *fname = path->path();
             if (strlen(fname) <= 0)
+            {
+                drop_embedded(descr);
                 return STATUS_UNSPECIFIED;
+            }
 
             // Load audio file
             dspu::Sample *af    = new dspu::Sample();
@@ -1108,167 +2275,1226 @@ namespace lsp
 
             lsp_trace("Loading file '%s'...", path);
 
-            // Try to load file
-            float conv_length_max_seconds = meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f;
-            status_t status = af->load(fname, conv_length_max_seconds);
-            if (status != STATUS_OK)
-            {
-                lsp_trace("Load file '%s' failed: status=%d (%s)", path, status, get_status(status));
+            // Try to restore data embedded into the state, then map uncompressed file, then decode it in chunks
+            size_t mask             = descr->nTracks | TRACKS_VISIBLE;
+            size_t channels         = 0;
+            float max               = 0.0f;
+            status_t status         = (bEmbed) ? load_embedded(descr, af, &max, &channels, fname, &mask) : STATUS_NOT_FOUND;
+            const bool embedded     = status == STATUS_OK;
+            if ((status != STATUS_OK) && (status != STATUS_NO_MEM))
+                status                  = load_prepared(af, &max, &channels, fname, mask);
+            if ((status != STATUS_OK) && (status != STATUS_NO_MEM))
+                status                  = load_mapped(af, &max, &channels, fname, mask);
+            if ((status != STATUS_OK) && (status != STATUS_NO_MEM))
+                status                  = load_stream(af, &max, &channels, fname, mask);
+            if (status == STATUS_NO_MEM)
                 return status;
-            }
+            else if (status != STATUS_OK)
+            {
+                lsp_trace("Streaming load of file '%s' failed: status=%d (%s), loading the whole file",
+                    fname, status, get_status(status));
 
-            // Determine the normalizing factor
-            size_t channels         = af->channels();
-            float max = 0.0f;
+                // Try to load file
+                float conv_length_max_seconds = meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f;
+                status = af->load(fname, conv_length_max_seconds);
+                if (status != STATUS_OK)
+                {
+                    lsp_trace("Load file '%s' failed: status=%d (%s)", path, status, get_status(status));
+                    return status;
+                }
 
-            for (size_t i=0; i<channels; ++i)
-            {
                 // Determine the maximum amplitude
-                float a_max = dsp::abs_max(af->channel(i), af->samples());
-                if (max < a_max)
-                    max     = a_max;
+                channels                = af->channels();
+                for (size_t i=0; i<channels; ++i)
+                {
+                    float a_max = dsp::abs_max(af->channel(i), af->samples());
+                    if (max < a_max)
+                        max     = a_max;
+                }
+
+                // Keep only tracks that are required by convolvers
+                if ((status = select_tracks(af, mask)) != STATUS_OK)
+                    return status;
             }
+
+            // Determine the normalizing factor
             descr->fNorm    = (max != 0.0f) ? 1.0f / max : 1.0f;
 
+            // Update the data embedded into the state
+            if (!bEmbed)
+                drop_embedded(descr);
+            else if (!embedded)
+                embed_file(descr, af, max, channels, fname, mask);
+
             // File was successfully loaded, pass result to the caller
             lsp::swap(descr->pOriginal, af);
+            descr->nLoadMask        = mask;
+            update_file_memory(descr);
 
             return STATUS_OK;
         }
 
-        status_t impulse_reverb::reconfigure()
+        void impulse_reverb::make_kvt_key(char *dst, size_t len, const af_descriptor_t *descr, const char *name) const
         {
-            // Re-render files
-            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
-            {
-                // Get audio file
-                af_descriptor_t *f  = &vFiles[i];
-                destroy_sample(f->pProcessed);
+            snprintf(dst, len, "/ir/%d/%s", int(descr - vFiles), name);
+        }
 
-                // Obtain the original sample
-                dspu::Sample *af    = f->pOriginal;
-                if (af == NULL)
-                    continue;
+        status_t impulse_reverb::load_embedded(af_descriptor_t *descr, dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t *mask)
+        {
+            char key[32];
+            core::KVTStorage *kvt = pWrapper->kvt_lock();
+            if (kvt == NULL)
+                return STATUS_NOT_FOUND;
+            lsp_finally { pWrapper->kvt_release(); };
+
+            // The embedded data should match the file name
+            const char *path        = NULL;
+            make_kvt_key(key, sizeof(key), descr, "path");
+            if ((kvt->get(key, &path) != STATUS_OK) || (path == NULL) || (strcmp(path, fname) != 0))
+                return STATUS_NOT_FOUND;
+
+            const core::kvt_param_t *p = NULL;
+            make_kvt_key(key, sizeof(key), descr, "data");
+            if ((kvt->get(key, &p, core::KVT_BLOB) != STATUS_OK) || (p->blob.data == NULL))
+                return STATUS_NOT_FOUND;
+            if (p->blob.size < sizeof(ir_blob_header_t))
+                return STATUS_CORRUPTED;
+
+            // Validate the header
+            ir_blob_header_t hdr;
+            memcpy(&hdr, p->blob.data, sizeof(hdr));
+            if ((hdr.nMagic != IR_BLOB_MAGIC) || (hdr.nVersion != IR_BLOB_VERSION))
+                return STATUS_BAD_FORMAT;
+            if ((hdr.nChannels <= 0) || (hdr.nLength <= 0) || (hdr.nSampleRate <= 0) || (hdr.nSrcChannels < hdr.nChannels))
+                return STATUS_CORRUPTED;
+
+            if ((hdr.nOffset > hdr.nLength) || (hdr.nStored > hdr.nLength - hdr.nOffset))
+                return STATUS_CORRUPTED;
+            if (p->blob.size < sizeof(hdr) + size_t(hdr.nChannels) * hdr.nStored * sizeof(float))
+                return STATUS_CORRUPTED;
+
+            // Tracks beyond the number of tracks in the original file do not exist, so they are never stored.
+            // All other requested tracks, including the ones loaded for thumbnails, should be stored.
+            const size_t valid      = (hdr.nSrcChannels < meta::impulse_reverb_metadata::TRACKS_MAX) ?
+                                      (size_t(1) << hdr.nSrcChannels) - 1 : ~size_t(0);
+            if (*mask & valid & (~size_t(hdr.nMask)))
+                return STATUS_NOT_FOUND;    // Not all requested tracks are stored
+
+            // The stored samples should cover the samples used by the current cut settings
+            size_t first = 0, last = 0;
+            embed_range(descr, hdr.nLength, hdr.nSampleRate, &first, &last);
+            if ((first < hdr.nOffset) || (last > hdr.nOffset + hdr.nStored))
+                return STATUS_NOT_FOUND;
+
+            // Restore the selected tracks
+            const size_t load       = *mask & hdr.nMask;
+            size_t tracks           = 0;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::TRACKS_MAX; ++i)
+                if (load & (size_t(1) << i))
+                    ++tracks;
+            if (tracks <= 0)
+                return STATUS_NOT_FOUND;
+            if (!af->init(tracks, hdr.nLength, hdr.nLength))
+                return STATUS_NO_MEM;
+            af->set_sample_rate(hdr.nSampleRate);
 
-                // Copy data of original sample to temporary sample and perform resampling if needed
-                dspu::Sample temp;
-                const size_t sample_rate_dst  = fSampleRate * dspu::semitones_to_frequency_shift(-f->fPitch);
-                if (sample_rate_dst != af->sample_rate())
+            const uint8_t *data     = static_cast<const uint8_t *>(p->blob.data) + sizeof(hdr);
+            const size_t tail       = hdr.nOffset + hdr.nStored;
+            for (size_t i=0, j=0, k=0; (i < meta::impulse_reverb_metadata::TRACKS_MAX) && (k < hdr.nChannels); ++i)
+            {
+                if (!(hdr.nMask & (size_t(1) << i)))
+                    continue;
+                if (load & (size_t(1) << i))
                 {
-                    if (temp.copy(af) != STATUS_OK)
-                    {
-                        lsp_warn("Error copying source sample");
-                        return STATUS_NO_MEM;
-                    }
-                    if (temp.resample(sample_rate_dst) != STATUS_OK)
-                    {
-                        lsp_warn("Error resampling source sample");
-                        return STATUS_NO_MEM;
-                    }
-                    af          = &temp;
+                    float *dst              = af->channel(j++);
+                    dsp::fill_zero(dst, hdr.nOffset);
+                    memcpy(&dst[hdr.nOffset], &data[k * hdr.nStored * sizeof(float)], hdr.nStored * sizeof(float));
+                    dsp::fill_zero(&dst[tail], hdr.nLength - tail);
                 }
+                ++k;
+            }
+            *peak                   = hdr.fPeak;
+            *channels               = hdr.nSrcChannels;
+            *mask                   = load | (*mask & (~valid));
+            descr->nEmbedMask       = hdr.nMask | (~valid);
+            descr->nEmbedFirst      = hdr.nOffset;
+            descr->nEmbedLast       = tail;
 
-                // Allocate new sample
-                dspu::Sample *s     = new dspu::Sample();
-                if (s == NULL)
-                    return STATUS_NO_MEM;
-                lsp_finally { destroy_sample(s); };
+            lsp_trace("Restored %d tracks of '%s' from state", int(tracks), fname);
 
-                const ssize_t flen  = af->samples();
-                size_t channels     = lsp_min(af->channels(), meta::impulse_reverb_metadata::TRACKS_MAX);
+            return STATUS_OK;
+        }
 
-                // Buffer is present, file is present, check boundaries
-                size_t head_cut     = dspu::millis_to_samples(fSampleRate, f->fHeadCut);
-                size_t tail_cut     = dspu::millis_to_samples(fSampleRate, f->fTailCut);
-                ssize_t fsamples    = flen - head_cut - tail_cut;
-                if (fsamples <= 0)
-                {
-                    for (size_t j=0; j<channels; ++j)
-                        dsp::fill_zero(f->vThumbs[j], meta::impulse_reverb_metadata::MESH_SIZE);
-                    s->set_length(0);
+        void impulse_reverb::embed_file(af_descriptor_t *descr, dspu::Sample *af, float peak, size_t channels, const char *fname, size_t mask)
+        {
+            // Do not retry embedding until the file is loaded again if something goes wrong
+            descr->nEmbedMask       = ~size_t(0);
+            descr->nEmbedFirst      = 0;
+            descr->nEmbedLast       = ~size_t(0);
+
+            // Store all loaded tracks, the tracks loaded for thumbnails are required to restore the file too
+            const size_t count      = af->channels();
+            size_t stored           = 0;
+            for (size_t i=0, j=0; (i < meta::impulse_reverb_metadata::TRACKS_MAX) && (j < count); ++i)
+            {
+                if (!(mask & (size_t(1) << i)))
                     continue;
-                }
+                stored                 |= size_t(1) << i;
+                ++j;
+            }
+            if (count <= 0)
+            {
+                drop_embedded(descr);
+                return;
+            }
 
-                // Now ensure that we have enough space for sample
-                if (!s->init(channels, flen, fsamples))
-                    return STATUS_NO_MEM;
+            // Store only the samples used by the current cut settings
+            size_t first = 0, last = 0;
+            embed_range(descr, af->length(), af->sample_rate(), &first, &last);
+            const size_t length     = last - first;
 
-                // Copy data to temporary buffer and apply fading
-                for (size_t i=0; i<channels; ++i)
-                {
-                    float *dst = s->channel(i);
-                    const float *src = af->channel(i);
+            // Serialize the data directly into the buffer which is passed to the storage
+            const size_t size       = sizeof(ir_blob_header_t) + count * length * sizeof(float);
+            uint8_t *blob           = static_cast<uint8_t *>(malloc(size));
+            if (blob == NULL)
+            {
+                lsp_warn("Not enough memory to embed impulse response data into state");
+                return;
+            }
+            bool delegated          = false;
+            lsp_finally {
+                if (!delegated)
+                    free(blob);
+            };
+
+            ir_blob_header_t *hdr   = reinterpret_cast<ir_blob_header_t *>(blob);
+            hdr->nMagic             = IR_BLOB_MAGIC;
+            hdr->nVersion           = IR_BLOB_VERSION;
+            hdr->nChannels          = uint32_t(count);
+            hdr->nLength            = uint32_t(af->length());
+            hdr->nSampleRate        = uint32_t(af->sample_rate());
+            hdr->nMask              = uint32_t(stored);
+            hdr->fPeak              = peak;
+            hdr->nSrcChannels       = uint32_t(channels);
+            hdr->nFlags             = 0;
+            hdr->nOffset            = uint32_t(first);
+            hdr->nStored            = uint32_t(length);
+
+            float *dst              = reinterpret_cast<float *>(&blob[sizeof(ir_blob_header_t)]);
+            for (size_t i=0; i<count; ++i)
+            {
+                memcpy(dst, &af->channel(i)[first], length * sizeof(float));
+                dst                    += length;
+            }
 
-                    // Copy sample data and apply fading
-                    if (f->bReverse)
-                    {
-                        dsp::reverse2(dst, &src[tail_cut], fsamples);
-                        dspu::fade_in(dst, dst, dspu::millis_to_samples(fSampleRate, f->fFadeIn), fsamples);
-                    }
-                    else
-                        dspu::fade_in(dst, &src[head_cut], dspu::millis_to_samples(fSampleRate, f->fFadeIn), fsamples);
-                    dspu::fade_out(dst, dst, dspu::millis_to_samples(fSampleRate, f->fFadeOut), fsamples);
+            // Store the data, the storage takes ownership of the buffer instead of copying it
+            char key[32];
+            core::KVTStorage *kvt = pWrapper->kvt_lock();
+            if (kvt == NULL)
+                return;
+            lsp_finally { pWrapper->kvt_release(); };
 
-                    // Now render thumbnail
-                    src                 = dst;
-                    dst                 = f->vThumbs[i];
-                    for (size_t k=0; k<meta::impulse_reverb_metadata::MESH_SIZE; ++k)
-                    {
-                        size_t first    = (k * fsamples) / meta::impulse_reverb_metadata::MESH_SIZE;
-                        size_t last     = ((k + 1) * fsamples) / meta::impulse_reverb_metadata::MESH_SIZE;
-                        if (first < last)
-                            dst[k]          = dsp::abs_max(&src[first], last - first);
-                        else
-                            dst[k]          = fabs(src[first]);
-                    }
+            core::kvt_param_t p;
+            p.type                  = core::KVT_BLOB;
+            p.blob.ctype            = "application/x-lsp-impulse-response";
+            p.blob.size             = size;
+            p.blob.data             = blob;
 
-                    // Normalize graph if possible
-                    if (f->fNorm != 1.0f)
-                        dsp::mul_k2(dst, f->fNorm, meta::impulse_reverb_metadata::MESH_SIZE);
-                }
+            make_kvt_key(key, sizeof(key), descr, "data");
+            delegated               = true;     // The storage is responsible for the buffer even if it fails
+            if (kvt->put(key, &p, core::KVT_PRIVATE | core::KVT_DELEGATE) != STATUS_OK)
+                return;
+            make_kvt_key(key, sizeof(key), descr, "path");
+            kvt->put(key, fname, core::KVT_PRIVATE);
+            descr->nEmbedMask       = stored | ((channels < meta::impulse_reverb_metadata::TRACKS_MAX) ?
+                                      ~((size_t(1) << channels) - 1) : 0);
+            descr->nEmbedFirst      = first;
+            descr->nEmbedLast       = last;
+
+            lsp_trace("Embedded %d tracks of '%s' into state, samples %d..%d of %d",
+                int(count), fname, int(first), int(last), int(af->length()));
+        }
 
-                // Commit sample to the processed list
-                lsp::swap(f->pProcessed, s);
-                f->fDuration        = dspu::samples_to_seconds(fSampleRate, flen);
-            }
+        void impulse_reverb::drop_embedded(af_descriptor_t *descr)
+        {
+            char key[32];
+            core::KVTStorage *kvt = pWrapper->kvt_lock();
+            if (kvt == NULL)
+                return;
+            lsp_finally { pWrapper->kvt_release(); };
+
+            make_kvt_key(key, sizeof(key), descr, "data");
+            kvt->remove(key, NULL, core::KVT_ANY);
+            make_kvt_key(key, sizeof(key), descr, "path");
+            kvt->remove(key, NULL, core::KVT_ANY);
+            descr->nEmbedMask       = 0;
+            descr->nEmbedFirst      = 0;
+            descr->nEmbedLast       = ~size_t(0);
+        }
 
-            // Randomize phase of the convolver
-            uint32_t phase  = seed_addr(this);
-            phase           = ((phase << 16) | (phase >> 16)) & 0x7fffffff;
-            uint32_t step   = 0x80000000 / (meta::impulse_reverb_metadata::CONVOLVERS + 1);
+        void impulse_reverb::source_cuts(const af_descriptor_t *f, size_t srate, size_t *head, size_t *tail) const
+        {
+            // The cuts are applied to the reversed sample, convert them to the samples of the original file
+            const size_t srate_dst      = fSampleRate * dspu::semitones_to_frequency_shift(-f->fPitch);
+            const size_t head_cut       = dspu::millis_to_samples(fSampleRate, (f->bReverse) ? f->fTailCut : f->fHeadCut);
+            const size_t tail_cut       = dspu::millis_to_samples(fSampleRate, (f->bReverse) ? f->fHeadCut : f->fTailCut);
 
-            // OK, files have been rendered, now need to commutate
-            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
-            {
-                convolver_t *c      = &vConvolvers[i];
-                destroy_convolver(c->pSwap);
+            *head                       = (srate_dst > 0) ? (head_cut * srate) / srate_dst : 0;
+            *tail                       = (srate_dst > 0) ? (tail_cut * srate) / srate_dst : 0;
+        }
+
+        void impulse_reverb::embed_range(const af_descriptor_t *f, size_t length, size_t srate, size_t *first, size_t *last) const
+        {
+            size_t head = 0, tail = 0;
+            source_cuts(f, srate, &head, &tail);
+
+            // Keep the margin for the resampler around the samples used by the cut settings
+            head                        = (head > EMBED_MARGIN) ? head - EMBED_MARGIN : 0;
+            tail                        = (tail > EMBED_MARGIN) ? tail - EMBED_MARGIN : 0;
+            *first                      = lsp_min(head, length);
+            *last                       = (tail < length) ? lsp_max(length - tail, *first) : *first;
+        }
+
+        bool impulse_reverb::embed_covers(const af_descriptor_t *f) const
+        {
+            const dspu::Sample *af      = f->pOriginal;
+            if (af == NULL)
+                return true;
+
+            size_t first = 0, last = 0;
+            embed_range(f, af->length(), af->sample_rate(), &first, &last);
+            return (first >= f->nEmbedFirst) && (last <= f->nEmbedLast);
+        }
+
+        static bool read_fully(io::File *fd, void *dst, size_t count)
+        {
+            uint8_t *ptr            = static_cast<uint8_t *>(dst);
+            while (count > 0)
+            {
+                const ssize_t n         = fd->read(ptr, count);
+                if (n <= 0)
+                    return false;
+                ptr                    += n;
+                count                  -= n;
+            }
+            return true;
+        }
+
+        status_t impulse_reverb::load_prepared(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask)
+        {
+            io::NativeFile fd;
+            status_t res    = fd.open(fname, io::File::FM_READ);
+            if (res != STATUS_OK)
+                return res;
+            lsp_finally { fd.close(); };
+
+            // Validate the header
+            prepared_ir_header_t hdr;
+            if (!read_fully(&fd, &hdr, sizeof(hdr)))
+                return STATUS_BAD_FORMAT;
+            if (!prepared_ir_signature(&hdr))
+                return STATUS_BAD_FORMAT;
+
+            // All fields of the file are little-endian
+            hdr.nVersion            = LE_TO_CPU(hdr.nVersion);
+            hdr.nHeaderSize         = LE_TO_CPU(hdr.nHeaderSize);
+            hdr.nChannels           = LE_TO_CPU(hdr.nChannels);
+            hdr.nLength             = LE_TO_CPU(hdr.nLength);
+            hdr.nSampleRate         = LE_TO_CPU(hdr.nSampleRate);
+            hdr.fPeak               = LE_TO_CPU(hdr.fPeak);
+
+            if ((hdr.nVersion != PREPARED_IR_VERSION) || (hdr.nHeaderSize < sizeof(hdr)))
+                return STATUS_UNSUPPORTED_FORMAT;
+            if ((hdr.nChannels <= 0) || (hdr.nLength <= 0) || (hdr.nSampleRate <= 0))
+                return STATUS_CORRUPTED;
+            // Tracks are selected by the bit mask, so files with more tracks can not be handled
+            if (hdr.nChannels > meta::impulse_reverb_metadata::TRACKS_MAX)
+                return STATUS_UNSUPPORTED_FORMAT;
+
+            const size_t length     = lsp_min(size_t(hdr.nLength),
+                dspu::seconds_to_samples(hdr.nSampleRate, meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f));
+            size_t tracks           = 0;
+            for (size_t i=0; i<hdr.nChannels; ++i)
+                if (mask & (size_t(1) << i))
+                    ++tracks;
+            if (tracks <= 0)
+                return STATUS_BAD_FORMAT;
+
+            // Read only the selected tracks, the data is already planar
+            if (!af->init(tracks, length, length))
+                return STATUS_NO_MEM;
+            af->set_sample_rate(hdr.nSampleRate);
+
+            for (size_t i=0, j=0; i<hdr.nChannels; ++i)
+            {
+                if (!(mask & (size_t(1) << i)))
+                    continue;
+
+                float *dst              = af->channel(j++);
+                const wssize_t offset   = wssize_t(hdr.nHeaderSize) + wssize_t(i) * hdr.nLength * sizeof(float);
+                if (fd.seek(offset, io::File::FSK_SET) != STATUS_OK)
+                    return STATUS_CORRUPTED;
+                if (!read_fully(&fd, dst, length * sizeof(float)))
+                    return STATUS_CORRUPTED;
+            #ifdef ARCH_BE
+                for (size_t k=0; k<length; ++k)
+                    dst[k]                  = LE_TO_CPU(dst[k]);
+            #endif /* ARCH_BE */
+            }
+            *peak                   = hdr.fPeak;
+            *channels               = hdr.nChannels;
+
+            lsp_trace("Read %d tracks of prepared file '%s'", int(tracks), fname);
+
+            return STATUS_OK;
+        }
+
+    #ifdef IR_MAPPED_WAV_SUPPORTED
+        static inline uint16_t read_le16(const uint8_t *p)
+        {
+            return uint16_t(p[0]) | (uint16_t(p[1]) << 8);
+        }
+
+        static inline uint32_t read_le32(const uint8_t *p)
+        {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+    #endif /* IR_MAPPED_WAV_SUPPORTED */
+
+        status_t impulse_reverb::load_mapped(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask)
+        {
+        #ifdef IR_MAPPED_WAV_SUPPORTED
+            int fd          = ::open(fname, O_RDONLY);
+            if (fd < 0)
+                return STATUS_IO_ERROR;
+            lsp_finally { ::close(fd); };
+
+            // Only regular files are mapped, other files are decoded by the stream reader
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+                return STATUS_IO_ERROR;
+            if (!S_ISREG(st.st_mode))
+                return STATUS_NOT_SUPPORTED;
+            const size_t size   = st.st_size;
+            if (size < 12)
+                return STATUS_BAD_FORMAT;
+
+            void *addr      = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+                return STATUS_IO_ERROR;
+            lsp_finally { ::munmap(addr, size); };
+
+            // Access to the pages beyond the end of the truncated file raises SIGBUS, so check that the
+            // file has not been truncated after it has been mapped and fall back to the stream reader
+            if ((::fstat(fd, &st) != 0) || (size_t(st.st_size) < size))
+                return STATUS_IO_ERROR;
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+
+            // Parse RIFF/WAVE header
+            const uint8_t *head = static_cast<const uint8_t *>(addr);
+            if ((memcmp(head, "RIFF", 4) != 0) || (memcmp(&head[8], "WAVE", 4) != 0))
+                return STATUS_BAD_FORMAT;
+
+            size_t nch = 0, srate = 0, data_off = 0, data_size = 0;
+            bool is_float   = false;
+            for (size_t off = 12; off + 8 <= size; )
+            {
+                const uint8_t *ck       = &head[off];
+                const size_t body       = off + 8;
+                const size_t ck_size    = lsp_min(size_t(read_le32(&ck[4])), size - body);
+
+                if ((memcmp(ck, "fmt ", 4) == 0) && (ck_size >= 16))
+                {
+                    uint16_t tag            = read_le16(&ck[8]);
+                    nch                     = read_le16(&ck[10]);
+                    srate                   = read_le32(&ck[12]);
+                    const uint16_t bits     = read_le16(&ck[22]);
+                    if ((tag == 0xfffe) && (ck_size >= 40))     // WAVE_FORMAT_EXTENSIBLE, take the sub-format
+                        tag                     = read_le16(&ck[32]);
+                    is_float                = (tag == 0x0003) && (bits == 32);
+                }
+                else if (memcmp(ck, "data", 4) == 0)
+                {
+                    data_off                = body;
+                    data_size               = ck_size;
+                }
+
+                off                     = body + ck_size + (ck_size & 1);
+            }
+
+            // Only 32-bit IEEE float data which is properly aligned can be read directly
+            if ((!is_float) || (nch <= 0) || (srate <= 0) || (data_off <= 0))
+                return STATUS_NOT_SUPPORTED;
+            if (data_off & (sizeof(float) - 1))
+                return STATUS_NOT_SUPPORTED;
+            // Tracks are selected by the bit mask, files with more tracks are left to the stream reader
+            if (nch > meta::impulse_reverb_metadata::TRACKS_MAX)
+                return STATUS_NOT_SUPPORTED;
+
+            const size_t max_length = dspu::seconds_to_samples(srate, meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f);
+            const size_t length     = lsp_min(data_size / (nch * sizeof(float)), max_length);
+            size_t tracks           = 0;
+            for (size_t i=0; i<nch; ++i)
+                if (mask & (size_t(1) << i))
+                    ++tracks;
+            if ((tracks <= 0) || (length <= 0))
+                return STATUS_BAD_FORMAT;
+
+            // De-interleave the selected tracks from the mapping
+            if (!af->init(tracks, length, length))
+                return STATUS_NO_MEM;
+            af->set_sample_rate(srate);
+
+            const float *data       = reinterpret_cast<const float *>(&head[data_off]);
+            for (size_t i=0, j=0; i<nch; ++i)
+            {
+                if (!(mask & (size_t(1) << i)))
+                    continue;
+
+                float *dst              = af->channel(j++);
+                const float *src        = &data[i];
+                for (size_t k=0; k<length; ++k, src += nch)
+                    dst[k]                  = *src;
+            }
+            *peak                   = dsp::abs_max(data, length * nch);
+            *channels               = nch;
+
+            lsp_trace("Mapped %d frames of %d tracks", int(length), int(tracks));
+
+            return STATUS_OK;
+        #else
+            return STATUS_NOT_SUPPORTED;
+        #endif /* IR_MAPPED_WAV_SUPPORTED */
+        }
+
+        status_t impulse_reverb::load_stream(dspu::Sample *af, float *peak, size_t *channels, const char *fname, size_t mask)
+        {
+            mm::InAudioFileStream is;
+            status_t res    = is.open(fname);
+            if (res != STATUS_OK)
+                return res;
+            lsp_finally { is.close(); };
+
+            mm::audio_stream_t info;
+            if ((res = is.info(&info)) != STATUS_OK)
+                return res;
+            if ((info.channels <= 0) || (info.srate <= 0))
+                return STATUS_BAD_FORMAT;
+
+            // Estimate the number of frames and tracks to store, tracks beyond the supported ones are dropped
+            const size_t nch        = info.channels;
+            const size_t nsel       = lsp_min(nch, meta::impulse_reverb_metadata::TRACKS_MAX);
+            const size_t max_length = dspu::seconds_to_samples(info.srate, meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f);
+            const size_t length     = (info.frames >= 0) ? lsp_min(size_t(info.frames), max_length) : max_length;
+            size_t tracks           = 0;
+            for (size_t i=0; i<nsel; ++i)
+                if (mask & (size_t(1) << i))
+                    ++tracks;
+            if (tracks <= 0)
+                return STATUS_BAD_FORMAT;
+
+            // Allocate only the selected tracks, the rest of data is dropped while decoding
+            if (!af->init(tracks, length, length))
+                return STATUS_NO_MEM;
+            af->set_sample_rate(info.srate);
+
+            const size_t chunk      = lsp_max(STREAM_CHUNK / nch, size_t(1));
+            uint8_t *data           = NULL;
+            float *buf              = alloc_aligned<float>(data, chunk * nch, DEFAULT_ALIGN);
+            if (buf == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { free_aligned(data); };
+
+            // Decode the file chunk by chunk
+            float max               = 0.0f;
+            size_t offset           = 0;
+            while (offset < length)
+            {
+                const ssize_t count     = is.read(buf, lsp_min(chunk, length - offset));
+                if (count < 0)
+                {
+                    if (count == -STATUS_EOF)
+                        break;
+                    return status_t(-count);
+                }
+                else if (count == 0)
+                    break;
+
+                // Update the peak value over all channels and de-interleave selected tracks
+                max                     = lsp_max(max, dsp::abs_max(buf, count * nch));
+                for (size_t i=0, j=0; i<nsel; ++i)
+                {
+                    if (!(mask & (size_t(1) << i)))
+                        continue;
+
+                    float *dst              = af->channel(j++) + offset;
+                    const float *src        = &buf[i];
+                    for (ssize_t k=0; k<count; ++k, src += nch)
+                        dst[k]                  = *src;
+                }
+
+                offset                 += count;
+            }
+
+            af->set_length(offset);
+            *peak                   = max;
+            *channels               = nsel;
+
+            lsp_trace("Decoded %d frames of %d tracks", int(offset), int(tracks));
+
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::select_tracks(dspu::Sample * &af, size_t mask)
+        {
+            const size_t channels   = af->channels();
+            const size_t length     = af->length();
+            size_t count            = 0;
+            for (size_t i=0; i<channels; ++i)
+                if (mask & (size_t(1) << i))
+                    ++count;
+            if (count >= channels)
+                return STATUS_OK;
+
+            lsp_trace("Keeping %d of %d tracks", int(count), int(channels));
+
+            // Copy selected tracks to the new sample
+            dspu::Sample *s         = new dspu::Sample();
+            if (s == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { destroy_sample(s); };
+
+            if (!s->init(count, length, length))
+                return STATUS_NO_MEM;
+            s->set_sample_rate(af->sample_rate());
+
+            for (size_t i=0, j=0; i<channels; ++i)
+                if (mask & (size_t(1) << i))
+                    dsp::copy(s->channel(j++), af->channel(i), length);
+
+            lsp::swap(af, s);
+
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::reconfigure()
+        {
+            // The deferred pass only creates convolvers which did not fit into the memory budget
+            const bool defer_pass   = bDeferPass;
+            sPool.set_limit(lsp_min(POOL_LIMIT, nReconfMem / 8));
+
+            // Re-render files
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                // Get audio file, the partial pass only creates the requested preview samples
+                af_descriptor_t *f  = &vFiles[i];
+                if (defer_pass)
+                {
+                    status_t res        = render_preview(f);
+                    if (res != STATUS_OK)
+                        return res;
+                    continue;
+                }
+                destroy_sample(f->pProcessed);
+
+                status_t res        = (bLean) ? render_lean(f) : render_normal(f);
+                if (res != STATUS_OK)
+                    return res;
+                update_file_memory(f);
+            }
+
+            // Release the previous data first, it is not used by the processing anymore
+            size_t held         = sPool.bytes();
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                const af_descriptor_t *f    = &vFiles[i];
+                held               += f->nMemory + f->nPlayMem + sample_memory(f->pProcessed);
+            }
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                convolver_t *c      = &vConvolvers[i];
+                destroy_convolver(c->pSwap);
+                c->nSwapMem         = 0;
+                for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                {
+                    destroy_convolver(c->vBankSwap[j]);
+                    c->vBankSwapMem[j]  = 0;
+                }
+                held               += convolver_memory(c);
+            }
+            size_t budget       = (nReconfMem > held) ? nReconfMem - held : 0;
+
+            // Randomize phase of the convolver
+            uint32_t phase  = seed_addr(this);
+            phase           = ((phase << 16) | (phase >> 16)) & 0x7fffffff;
+            uint32_t step   = 0x80000000 / (meta::impulse_reverb_metadata::CONVOLVERS + 1);
+
+            // OK, files have been rendered, now need to commutate
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            {
+                convolver_t *c      = &vConvolvers[i];
+
+                // The deferred pass keeps all convolvers except deferred ones and rebuilds the convolvers of the
+                // channel with settled morphing or with stale convolvers
+                const size_t build_req  = c->nBuildReq;
+                const bool rebuild      = (defer_pass) && (!c->bDefer) && (build_req != c->nBuildResp);
+                c->bKeep            = (defer_pass) && (!c->bDefer) && (!rebuild);
+                c->bRebuild         = rebuild;
+                c->bDefer           = false;
+                c->nBuildResp       = build_req;
+                if (c->bKeep)
+                    continue;
+
+                // The regular convolver is not needed while IR bank is in use, the rebuild keeps the mode
+                if (!rebuild)
+                    c->bBankSwap        = c->bBankReq;
+                if (c->bBankSwap)
+                    continue;
 
                 // Check that routing has changed
-                size_t file         = c->nFile;
-                size_t track        = c->nTrack;
+                const size_t file   = c->nFile;
+                const size_t track  = c->nTrack;
                 if ((file <= 0) || (file > meta::impulse_reverb_metadata::FILES))
                     continue;
-                --file;
+                const size_t target = (c->nMorphFile > 0) ? c->nMorphFile - 1 : file - 1;
 
-                // Analyze sample
-                dspu::Sample *s = vFiles[file].pProcessed;
-                if ((s == NULL) || (!s->valid()) || (s->channels() <= track))
+                const float cv_phase= float((phase + i*step)& 0x7fffffff)/float(0x80000000);
+                // The old convolver has been already released by the deferred pass, do not limit it
+                size_t *cv_budget   = ((defer_pass) && (!rebuild)) ? NULL : &budget;
+                status_t res        = create_convolver(&c->pSwap, &c->nSwapMem, file - 1, track, target, c->fMorph, cv_phase, cv_budget);
+                if ((rebuild) && (res == STATUS_OVERFLOW) && (!c->bStale))
+                {
+                    // Keep the current convolver until the next reconfiguration
+                    lsp_trace("Rebuilt convolver for channel %d does not fit into reconfiguration memory budget", int(i));
+                    c->bKeep            = true;
+                    c->bRebuild         = false;
+                    continue;
+                }
+                else if (res == STATUS_OVERFLOW)
+                {
+                    // Mute the convolver on swap and create it when the old one has been released
+                    lsp_trace("Convolver for channel %d does not fit into reconfiguration memory budget, deferring", int(i));
+                    c->bDefer           = true;
                     continue;
+                }
+                else if (res != STATUS_OK)
+                    return res;
+                lsp_trace("Allocated convolver pSwap=%p for channel %d (pCurr=%p)", c->pSwap, int(i), c->pCurr);
+            }
+
+            // Prepare IR banks: the selected entries take the memory budget first, then all other entries
+            size_t bank_mem     = nBankMem;
+            for (size_t pass=0; pass<2; ++pass)
+            {
+                for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                {
+                    convolver_t *c      = &vConvolvers[i];
+                    if ((!c->bBankSwap) || (c->bKeep))
+                        continue;
+
+                    for (size_t j=0; j<meta::impulse_reverb_metadata::FILES; ++j)
+                    {
+                        if ((c->vBankSwap[j] != NULL) || ((pass == 0) != (j + 1 == c->nFile)))
+                            continue;
+                        if ((c->bRebuild) && (!c->vStale[j]))
+                            continue;
+
+                        status_t res        = create_convolver(&c->vBankSwap[j], &c->vBankSwapMem[j], j, c->nTrack, j, 0.0f, float((phase + i*step)& 0x7fffffff)/float(0x80000000), &bank_mem);
+                        if (res == STATUS_OVERFLOW)
+                            continue;
+                        else if (res != STATUS_OK)
+                            return res;
+                    }
+                }
+            }
+
+            // The memory-lean mode does not keep recycled samples between reconfigurations
+            if (bLean)
+                sPool.clear();
+
+            // Account memory: both the active and the prepared data are held at this moment
+            size_t peak         = 0;
+            for (size_t i=0; i<meta::impulse_reverb_metadata::FILES; ++i)
+            {
+                const af_descriptor_t *f    = &vFiles[i];
+                peak               += f->nMemory + f->nPlayMem + sample_memory(f->pProcessed);
+            }
+            for (size_t i=0; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+                peak               += convolver_memory(&vConvolvers[i]);
+            nMemPeak            = lsp_max(nMemPeak, peak);
+
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::reload_original(af_descriptor_t *f)
+        {
+            // Memory-lean mode could drop the original sample, re-read it from disk
+            if ((f->pOriginal != NULL) || (f->nStatus != STATUS_OK))
+                return STATUS_OK;
+
+            lsp_trace("Re-loading original sample for file descriptor %p", f);
+            status_t res        = load(f);
+            if (res != STATUS_OK)
+            {
+                // The file could be moved or deleted, report the status but continue configuration
+                lsp_warn("Error re-loading original sample: code=%d (%s)", int(res), get_status(res));
+                f->nStatus          = res;
+            }
 
-                // Now we can create convolver
-                dspu::Convolver *cv   = new dspu::Convolver();
-                if (cv == NULL)
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::render_normal(af_descriptor_t *f)
+        {
+            sPool.release(f->pRendered);
+            f->bRender          = false;
+
+            status_t res        = reload_original(f);
+            if (res != STATUS_OK)
+                return res;
+
+            return render_file(f, &f->pProcessed);
+        }
+
+        status_t impulse_reverb::render_lean(af_descriptor_t *f)
+        {
+            // Render the file only if rendering parameters have changed
+            if (f->bRender)
+            {
+                f->bRender          = false;
+                sPool.release(f->pRendered);
+
+                status_t res        = reload_original(f);
+                if (res != STATUS_OK)
+                    return res;
+                if ((res = render_file(f, &f->pRendered)) != STATUS_OK)
+                    return res;
+
+                // Only the rendered sample is kept, the source data is freed instead of being recycled
+                destroy_sample(f->pOriginal);
+                destroy_sample(f->pResampled);
+            }
+
+            return render_preview(f);
+        }
+
+        status_t impulse_reverb::render_preview(af_descriptor_t *f)
+        {
+            // Create the preview sample on demand
+            if ((!f->bPreview) || (f->bPreviewDone))
+                return STATUS_OK;
+            f->bPreviewDone     = true;
+            if (f->pRendered == NULL)
+                return STATUS_OK;
+
+            dspu::Sample *s     = new dspu::Sample();
+            if (s == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { destroy_sample(s); };
+
+            if (s->copy(f->pRendered) != STATUS_OK)
+                return STATUS_NO_MEM;
+
+            lsp::swap(f->pProcessed, s);
+
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::render_file(af_descriptor_t *f, dspu::Sample **out)
+        {
+            f->nChannels        = 0;
+
+            // Obtain the original sample
+            dspu::Sample *af    = f->pOriginal;
+            if (af == NULL)
+                return STATUS_OK;
+
+            // Obtain the resampled data of the original sample
+            size_t head_cut     = 0;
+            size_t tail_cut     = 0;
+            status_t res        = resample_original(f, &af, &head_cut, &tail_cut);
+            if (res != STATUS_OK)
+                return res;
+
+            // The sample is allocated from the pool after the boundaries are checked
+            dspu::Sample *s     = NULL;
+            lsp_finally { sPool.release(s); };
+
+            const ssize_t flen  = af->samples();
+            size_t channels     = lsp_min(af->channels(), meta::impulse_reverb_metadata::TRACKS_MAX);
+
+            // Buffer is present, file is present, check boundaries
+            ssize_t fsamples    = flen - head_cut - tail_cut;
+            if (fsamples <= 0)
+            {
+                for (size_t j=0; j<channels; ++j)
+                    dsp::fill_zero(f->vThumbs[j], meta::impulse_reverb_metadata::MESH_SIZE);
+                return STATUS_OK;
+            }
+
+            // Now ensure that we have enough space for sample
+            if ((s = sPool.alloc(channels, fsamples)) == NULL)
+                return STATUS_NO_MEM;
+            s->set_sample_rate(fSampleRate);
+
+            // Copy data to temporary buffer and apply fading
+            const size_t fade_in    = dspu::millis_to_samples(fSampleRate, f->fFadeIn);
+            const size_t fade_out   = dspu::millis_to_samples(fSampleRate, f->fFadeOut);
+            for (size_t i=0; i<channels; ++i)
+            {
+                float *dst = s->channel(i);
+                const float *src = af->channel(i);
+
+                // Copy sample data and apply fading
+                if (f->bReverse)
+                {
+                    dsp::reverse2(dst, &src[tail_cut], fsamples);
+                    dspu::fade_in(dst, dst, fade_in, fsamples);
+                }
+                else
+                    dspu::fade_in(dst, &src[head_cut], fade_in, fsamples);
+                dspu::fade_out(dst, dst, fade_out, fsamples);
+            }
+
+            // Now render thumbnails
+            if ((res = update_peaks(f, s, head_cut, tail_cut, fade_in, fade_out)) != STATUS_OK)
+                return res;
+            render_thumbnails(f, s);
+
+            // Commit sample to the processed list
+            lsp::swap(*out, s);
+            f->nChannels        = channels;
+
+            return STATUS_OK;
+        }
+
+        void impulse_reverb::init_peaks(peaks_t *p)
+        {
+            p->vData            = NULL;
+            p->pData            = NULL;
+            p->nChannels        = 0;
+            p->nLength          = 0;
+            p->nBlocks          = 0;
+            p->nStride          = 0;
+            p->nSource          = 0;
+            p->nHeadCut         = 0;
+            p->nTailCut         = 0;
+            p->nFadeIn          = 0;
+            p->nFadeOut         = 0;
+            p->bReverse         = false;
+        }
+
+        void impulse_reverb::destroy_peaks(peaks_t *p)
+        {
+            free_aligned(p->pData);
+            init_peaks(p);
+        }
+
+        void impulse_reverb::update_peak_blocks(peaks_t *p, dspu::Sample *s, size_t first, size_t last)
+        {
+            for (size_t i=0; i<p->nChannels; ++i)
+            {
+                const float *src    = s->channel(i);
+                float *dst          = &p->vData[i * p->nStride];
+                for (size_t j=first; j<last; ++j)
+                {
+                    const size_t offset = j * PEAK_BLOCK;
+                    dst[j]              = dsp::abs_max(&src[offset], lsp_min(p->nLength - offset, PEAK_BLOCK));
+                }
+            }
+        }
+
+        status_t impulse_reverb::update_peaks(af_descriptor_t *f, dspu::Sample *s, size_t head_cut, size_t tail_cut, size_t fade_in, size_t fade_out)
+        {
+            peaks_t *p              = &f->sPeaks;
+            const size_t channels   = s->channels();
+            const size_t length     = s->length();
+            const size_t blocks     = (length + PEAK_BLOCK - 1) / PEAK_BLOCK;
+
+            // Short samples are analyzed directly
+            if (blocks < meta::impulse_reverb_metadata::MESH_SIZE)
+            {
+                destroy_peaks(p);
+                return STATUS_OK;
+            }
+
+            const bool valid        =
+                (p->vData != NULL) &&
+                (p->nSource == f->nSourceGen) &&
+                (p->nChannels == channels) &&
+                (p->nLength == length) &&
+                (p->nHeadCut == head_cut) &&
+                (p->nTailCut == tail_cut) &&
+                (p->bReverse == f->bReverse);
+
+            if (valid)
+            {
+                // Only fades could change, update blocks covered by the previous and the new fades
+                const size_t head       = lsp_min((lsp_max(fade_in, p->nFadeIn) + PEAK_BLOCK - 1) / PEAK_BLOCK, blocks);
+                const size_t tail       = lsp_min(lsp_max(fade_out, p->nFadeOut), length);
+                const size_t tail_first = lsp_max((length - tail) / PEAK_BLOCK, head);
+                if ((fade_in == p->nFadeIn) && (fade_out == p->nFadeOut))
+                    return STATUS_OK;
+
+                update_peak_blocks(p, s, 0, head);
+                if (tail > 0)
+                    update_peak_blocks(p, s, tail_first, blocks);
+            }
+            else
+            {
+                // Compute the size of all levels of the pyramid
+                size_t stride           = 0;
+                for (size_t n = blocks; n >= meta::impulse_reverb_metadata::MESH_SIZE; n = (n + 1) / 2)
+                {
+                    stride                 += n;
+                    if (n <= 1)
+                        break;
+                }
+
+                destroy_peaks(p);
+                p->vData                = alloc_aligned<float>(p->pData, stride * channels, DEFAULT_ALIGN);
+                if (p->vData == NULL)
                     return STATUS_NO_MEM;
-                lsp_finally { destroy_convolver(cv); };
 
-                if (!cv->init(s->channel(track), s->length(), nRank, float((phase + i*step)& 0x7fffffff)/float(0x80000000)))
+                p->nChannels            = channels;
+                p->nLength              = length;
+                p->nBlocks              = blocks;
+                p->nStride              = stride;
+                p->nSource              = f->nSourceGen;
+                p->nHeadCut             = head_cut;
+                p->nTailCut             = tail_cut;
+                p->bReverse             = f->bReverse;
+
+                update_peak_blocks(p, s, 0, blocks);
+            }
+
+            p->nFadeIn              = fade_in;
+            p->nFadeOut             = fade_out;
+
+            // Rebuild coarser levels of the pyramid, they are small compared to the finest level
+            for (size_t i=0; i<channels; ++i)
+            {
+                float *src              = &p->vData[i * p->nStride];
+                for (size_t n = blocks; ((n + 1) / 2) >= meta::impulse_reverb_metadata::MESH_SIZE; )
+                {
+                    float *dst              = &src[n];
+                    const size_t half       = n / 2;
+                    for (size_t j=0; j<half; ++j)
+                        dst[j]                  = lsp_max(src[j*2], src[j*2 + 1]);
+                    if (n & 1)
+                        dst[half]               = src[n - 1];
+
+                    src                     = dst;
+                    n                       = (n + 1) / 2;
+                }
+            }
+
+            return STATUS_OK;
+        }
+
+        void impulse_reverb::render_thumbnails(af_descriptor_t *f, dspu::Sample *s)
+        {
+            const peaks_t *p        = &f->sPeaks;
+
+            for (size_t i=0; i<s->channels(); ++i)
+            {
+                // Use the coarsest level of the pyramid that still has enough resolution
+                const float *src;
+                size_t count;
+                if (p->vData != NULL)
+                {
+                    src                     = &p->vData[i * p->nStride];
+                    count                   = p->nBlocks;
+                    while (((count + 1) / 2) >= meta::impulse_reverb_metadata::MESH_SIZE)
+                    {
+                        src                    += count;
+                        count                   = (count + 1) / 2;
+                    }
+                }
+                else
+                {
+                    src                     = s->channel(i);
+                    count                   = s->length();
+                }
+
+                float *dst              = f->vThumbs[i];
+                for (size_t k=0; k<meta::impulse_reverb_metadata::MESH_SIZE; ++k)
+                {
+                    size_t first    = (k * count) / meta::impulse_reverb_metadata::MESH_SIZE;
+                    size_t last     = ((k + 1) * count) / meta::impulse_reverb_metadata::MESH_SIZE;
+                    if (first < last)
+                        dst[k]          = dsp::abs_max(&src[first], last - first);
+                    else
+                        dst[k]          = fabs(src[first]);
+                }
+
+                // Normalize graph if possible
+                if (f->fNorm != 1.0f)
+                    dsp::mul_k2(dst, f->fNorm, meta::impulse_reverb_metadata::MESH_SIZE);
+            }
+        }
+
+        status_t impulse_reverb::resample_original(af_descriptor_t *f, dspu::Sample **src, size_t *head_cut, size_t *tail_cut)
+        {
+            dspu::Sample *af            = f->pOriginal;
+            const size_t srate_src      = af->sample_rate();
+            const size_t srate_dst      = fSampleRate * dspu::semitones_to_frequency_shift(-f->fPitch);
+            const size_t head           = dspu::millis_to_samples(fSampleRate, f->fHeadCut);
+            const size_t tail           = dspu::millis_to_samples(fSampleRate, f->fTailCut);
+
+            f->fDuration                = dspu::samples_to_seconds(fSampleRate, (af->samples() * srate_dst) / srate_src);
+
+            // Use the original sample if there is no need for resampling
+            if (srate_dst == srate_src)
+            {
+                if (f->pResampled != NULL)
+                {
+                    destroy_sample(f->pResampled);
+                    ++f->nSourceGen;
+                }
+                *src                        = af;
+                *head_cut                   = head;
+                *tail_cut                   = tail;
+                return STATUS_OK;
+            }
+
+            // Cut the original sample before resampling, so the cache can be reused when only
+            // fades or routing change
+            size_t head_src = 0, tail_src = 0;
+            source_cuts(f, srate_src, &head_src, &tail_src);
+            const ssize_t length        = ssize_t(af->samples()) - head_src - tail_src;
+            if (length <= 0)
+            {
+                *src                        = af;
+                *head_cut                   = af->samples();
+                *tail_cut                   = 0;
+                return STATUS_OK;
+            }
+
+            if ((f->pResampled == NULL) ||
+                (f->nResampleRate != srate_dst) ||
+                (f->nResampleHead != head_src) ||
+                (f->nResampleTail != tail_src))
+            {
+                lsp_trace("Resampling %d samples from %d to %d Hz", int(length), int(srate_src), int(srate_dst));
+
+                // The resampler replaces the buffer of the sample with a newly allocated one, so it works
+                // on a temporary sample and the result is copied to the pooled sample of the target length
+                dspu::Sample tmp;
+                if (!tmp.init(af->channels(), length, length))
                     return STATUS_NO_MEM;
+                tmp.set_sample_rate(srate_src);
+                for (size_t i=0; i<af->channels(); ++i)
+                    dsp::copy(tmp.channel(i), &af->channel(i)[head_src], length);
 
-                // Commit result
-                lsp_trace("Allocated convolver pSwap=%p for channel %d (pCurr=%p)", cv, int(i), c->pCurr);
-                lsp::swap(c->pSwap, cv);
+                if (tmp.resample(srate_dst) != STATUS_OK)
+                {
+                    lsp_warn("Error resampling source sample");
+                    return STATUS_NO_MEM;
+                }
+
+                dspu::Sample *rs            = sPool.alloc(tmp.channels(), tmp.length());
+                if (rs == NULL)
+                    return STATUS_NO_MEM;
+                lsp_finally { sPool.release(rs); };
+
+                rs->set_sample_rate(srate_dst);
+                for (size_t i=0; i<tmp.channels(); ++i)
+                    dsp::copy(rs->channel(i), tmp.channel(i), tmp.length());
+
+                lsp::swap(f->pResampled, rs);
+                ++f->nSourceGen;
+                f->nResampleRate            = srate_dst;
+                f->nResampleHead            = head_src;
+                f->nResampleTail            = tail_src;
             }
 
+            *src                        = f->pResampled;
+            *head_cut                   = 0;
+            *tail_cut                   = 0;
+
+            return STATUS_OK;
+        }
+
+        status_t impulse_reverb::create_convolver(dspu::Convolver **dst, size_t *mem, size_t file, size_t track, size_t target, float morph, float phase, size_t *budget)
+        {
+            // Analyze sample
+            af_descriptor_t *af = &vFiles[file];
+            dspu::Sample *s     = rendered_sample(af);
+            const ssize_t index = track_index(af, track);
+            if ((s == NULL) || (!s->valid()) || (index < 0) || (s->channels() <= size_t(index)))
+                return STATUS_OK;
+
+            const float *ir     = s->channel(index);
+            size_t length       = s->length();
+
+            // Analyze the morph target sample
+            const float *tg_ir  = NULL;
+            size_t tg_length    = 0;
+            if ((morph > 0.0f) && (target != file) && (target < meta::impulse_reverb_metadata::FILES))
+            {
+                af_descriptor_t *tf = &vFiles[target];
+                dspu::Sample *ts    = rendered_sample(tf);
+                const ssize_t tg_index  = track_index(tf, track);
+                if ((ts != NULL) && (ts->valid()) && (tg_index >= 0) && (ts->channels() > size_t(tg_index)))
+                {
+                    tg_ir               = ts->channel(tg_index);
+                    tg_length           = ts->length();
+                }
+            }
+            if ((tg_ir != NULL) && (morph >= 1.0f))
+            {
+                ir                  = tg_ir;
+                length              = tg_length;
+                tg_ir               = NULL;
+            }
+            const size_t total  = (tg_ir != NULL) ? lsp_max(length, tg_length) : length;
+
+            // Check that the convolver fits into the memory budget
+            if (budget != NULL)
+            {
+                const size_t size   = convolver_size(total, nRank);
+                if (size > *budget)
+                {
+                    lsp_trace("Convolver for file %d track %d does not fit into memory budget", int(file), int(track));
+                    return STATUS_OVERFLOW;
+                }
+                *budget            -= size;
+            }
+
+            if (tg_ir == NULL)
+                return init_convolver(dst, mem, ir, length, phase);
+
+            // Convolution is linear, so the convolver of the blended impulse responses produces the blend
+            // of the outputs of both impulse responses at the cost of a single convolver
+            uint8_t *data       = NULL;
+            float *buf          = alloc_aligned<float>(data, total, DEFAULT_ALIGN);
+            if (buf == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { free_aligned(data); };
+
+            dsp::mul_k3(buf, ir, 1.0f - morph, length);
+            dsp::fill_zero(&buf[length], total - length);
+            dsp::fmadd_k3(buf, tg_ir, morph, tg_length);
+
+            return init_convolver(dst, mem, buf, total, phase);
+        }
+
+        status_t impulse_reverb::init_convolver(dspu::Convolver **dst, size_t *mem, const float *data, size_t length, float phase)
+        {
+            // Now we can create convolver
+            dspu::Convolver *cv = new dspu::Convolver();
+            if (cv == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { destroy_convolver(cv); };
+
+            if (!cv->init(data, length, nRank, phase))
+                return STATUS_NO_MEM;
+
+            // Commit result
+            lsp::swap(*dst, cv);
+            *mem                = sizeof(dspu::Convolver) + convolver_size(length, nRank);
+
             return STATUS_OK;
         }
 
@@ -1280,7 +3506,38 @@ namespace lsp
             v->write("nReconfigReq", nReconfigReq);
             v->write("nReconfigResp", nReconfigResp);
             v->write("nRank", nRank);
+            v->write("nBlockSize", nBlockSize);
+            v->write("bOffline", bOffline);
+            v->write("nXFade", nXFade);
+            v->write("nBankMem", nBankMem);
+            v->write("nReconfMem", nReconfMem);
+            v->write("nReserved", nReserved);
+            v->write("bRestore", bRestore);
+            v->write("bRestoreBatch", bRestoreBatch);
+            v->write("bRestoreConfig", bRestoreConfig);
+            v->write("bRestoreCheck", bRestoreCheck);
+            v->write("nRestoreHold", nRestoreHold);
+            v->write("nWorkers", nWorkers);
+            v->write("nWorkerPrio", nWorkerPrio);
+            v->write("nPoolWorkers", nPoolWorkers);
+            v->write("nPoolPrio", nPoolPrio);
+            v->write("bDeferPending", bDeferPending);
+            v->write("bDeferPass", bDeferPass);
+            v->write("bLean", bLean);
+            v->write("bEmbed", bEmbed);
+            v->write("bSnapGains", bSnapGains);
+            v->write("bFlush", bFlush);
+            v->write("bFlushPass", bFlushPass);
+            v->write("fCpuLoad", fCpuLoad);
+            v->write("nMemPeak", nMemPeak);
+            v->write("fDeadline", fDeadline);
+            v->write("nMisses", nMisses);
+            v->writev("vMissCause", vMissCause, MISS_TOTAL);
+            v->write("nReqTime", nReqTime);
+            v->write("nSubmitTime", nSubmitTime);
             v->write("pGCList", pGCList);
+            v->write("nConvClaim", nConvClaim);
+            v->write("nConvSamples", nConvSamples);
 
             v->begin_array("vInputs", vInputs, 2);
             {
@@ -1312,6 +3569,13 @@ namespace lsp
                         v->write("vOut", c->vOut);
                         v->write("vBuffer", c->vBuffer);
                         v->writev("fDryPan", c->fDryPan, 2);
+                        v->writev("fOldDryPan", c->fOldDryPan, 2);
+                        v->writev("vEqGain", c->vEqGain, meta::impulse_reverb_metadata::EQ_BANDS);
+                        v->write("fLowFreq", c->fLowFreq);
+                        v->write("fHighFreq", c->fHighFreq);
+                        v->write("nLowSlope", c->nLowSlope);
+                        v->write("nHighSlope", c->nHighSlope);
+                        v->write("bEqReset", c->bEqReset);
 
                         v->write("pOut", c->pOut);
 
@@ -1337,10 +3601,43 @@ namespace lsp
 
                         v->write_object("pCurr", c->pCurr);
                         v->write_object("pSwap", c->pSwap);
+                        v->writev("vBank", c->vBank, meta::impulse_reverb_metadata::FILES);
+                        v->writev("vBankSwap", c->vBankSwap, meta::impulse_reverb_metadata::FILES);
+
+                        v->begin_object("sFade", &c->sFade, sizeof(xfade_t));
+                        {
+                            v->write("pOld", c->sFade.pOld);
+                            v->write("nPos", c->sFade.nPos);
+                            v->write("nLen", c->sFade.nLen);
+                        }
+                        v->end_object();
+                        v->write("nBuildReq", c->nBuildReq);
+                        v->write("nBuildResp", c->nBuildResp);
+                        v->write("bRebuild", c->bRebuild);
+                        v->write("bDefer", c->bDefer);
+                        v->write("bKeep", c->bKeep);
+                        v->write("bMute", c->bMute);
+                        v->write("bBank", c->bBank);
+                        v->write("bBankSwap", c->bBankSwap);
+                        v->write("bBankReq", c->bBankReq);
+                        v->write("bStale", c->bStale);
+                        v->writev("vStale", c->vStale, meta::impulse_reverb_metadata::FILES);
+                        v->write("nCurrMem", c->nCurrMem);
+                        v->write("nSwapMem", c->nSwapMem);
+                        v->writev("vBankMem", c->vBankMem, meta::impulse_reverb_metadata::FILES);
+                        v->writev("vBankSwapMem", c->vBankSwapMem, meta::impulse_reverb_metadata::FILES);
+                        v->write("nFile", c->nFile);
+                        v->write("nTrack", c->nTrack);
+                        v->write("nMorphFile", c->nMorphFile);
+                        v->write("fMorph", c->fMorph);
+                        v->write("nMorphHold", c->nMorphHold);
 
                         v->write("vBuffer", c->vBuffer);
+                        v->write("vTemp", c->vTemp);
                         v->writev("fPanIn", c->fPanIn, 2);
                         v->writev("fPanOut", c->fPanOut, 2);
+                        v->writev("fOldPanIn", c->fOldPanIn, 2);
+                        v->writev("fOldPanOut", c->fOldPanOut, 2);
 
                         v->write("pMakeup", c->pMakeup);
                         v->write("pPanIn", c->pPanIn);
@@ -1350,6 +3647,10 @@ namespace lsp
                         v->write("pPredelay", c->pPredelay);
                         v->write("pMute", c->pMute);
                         v->write("pActivity", c->pActivity);
+                        v->write("pBank", c->pBank);
+                        v->write("pMorphFile", c->pMorphFile);
+                        v->write("pMorph", c->pMorph);
+                        v->write("pMemory", c->pMemory);
                     }
                     v->end_object();
                 }
@@ -1366,14 +3667,49 @@ namespace lsp
                         v->write_object("sStop", &af->sStop);
                         v->write_object("pOriginal", af->pOriginal);
                         v->write_object("pProcessed", af->pProcessed);
+                        v->write_object("pRendered", af->pRendered);
+                        v->write_object("pResampled", af->pResampled);
 
                         v->writev("vThumbs", af->vThumbs, meta::impulse_reverb_metadata::TRACKS_MAX);
 
                         v->write("fNorm", af->fNorm);
                         v->write("nStatus", af->nStatus);
+                        v->write("nChannels", af->nChannels);
+                        v->write("nTracks", af->nTracks);
+                        v->write("nLoadMask", af->nLoadMask);
+                        v->write("nEmbedMask", af->nEmbedMask);
+                        v->write("nEmbedFirst", af->nEmbedFirst);
+                        v->write("nEmbedLast", af->nEmbedLast);
+                        v->write("nResampleRate", af->nResampleRate);
+                        v->write("nResampleHead", af->nResampleHead);
+                        v->write("nResampleTail", af->nResampleTail);
+                        v->write("nSourceGen", af->nSourceGen);
+                        v->begin_object("sPeaks", &af->sPeaks, sizeof(peaks_t));
+                        {
+                            const peaks_t *p = &af->sPeaks;
+                            v->write("vData", p->vData);
+                            v->write("pData", p->pData);
+                            v->write("nChannels", p->nChannels);
+                            v->write("nLength", p->nLength);
+                            v->write("nBlocks", p->nBlocks);
+                            v->write("nStride", p->nStride);
+                            v->write("nSource", p->nSource);
+                            v->write("nHeadCut", p->nHeadCut);
+                            v->write("nTailCut", p->nTailCut);
+                            v->write("nFadeIn", p->nFadeIn);
+                            v->write("nFadeOut", p->nFadeOut);
+                            v->write("bReverse", p->bReverse);
+                        }
+                        v->end_object();
                         v->write("bRender", af->bRender);
                         v->write("bSync", af->bSync);
                         v->write("bReverse", af->bReverse);
+                        v->write("bPreview", af->bPreview);
+                        v->write("bPreviewDone", af->bPreviewDone);
+                        v->write("bReload", af->bReload);
+                        perf::dump(v, "sLoadTime", &af->sLoadTime);
+                        v->write("nMemory", af->nMemory);
+                        v->write("nPlayMem", af->nPlayMem);
 
                         v->write("fPitch", af->fPitch);
                         v->write("fHeadCut", af->fHeadCut);
@@ -1396,12 +3732,27 @@ namespace lsp
                         v->write("pStatus", af->pStatus);
                         v->write("pLength", af->pLength);
                         v->write("pThumbs", af->pThumbs);
+                        v->write("pMemory", af->pMemory);
                     }
                     v->end_object();
                 }
             }
             v->end_array();
             v->write_object("sConfigurator", &sConfigurator);
+            v->write_object("sPool", &sPool);
+            v->write_object("sExecutorTask", &sExecutorTask);
+            v->write_object_array("vConvTasks", vConvTasks, meta::impulse_reverb_metadata::CONVOLVERS - 1);
+            v->write_object("sQueue", &sQueue);
+            v->begin_array("vStages", vStages, STG_TOTAL);
+            {
+                for (size_t i=0; i<STG_TOTAL; ++i)
+                    perf::dump(v, NULL, &vStages[i]);
+            }
+            v->end_array();
+            perf::dump(v, "sConfigTime", &sConfigTime);
+            perf::dump(v, "sGCTime", &sGCTime);
+            perf::dump(v, "sReconfigLatency", &sReconfigLatency);
+            perf::dump(v, "sRestoreTime", &sRestoreTime);
 
             v->write("pBypass", pBypass);
             v->write("pRank", pRank);
@@ -1412,9 +3763,25 @@ namespace lsp
             v->write("pPredelay", pPredelay);
             v->write("pWetEq", pWetEq);
             v->write("pWetSplit", pWetSplit);
+            v->write("pXFade", pXFade);
+            v->write("pBankMem", pBankMem);
+            v->write("pLean", pLean);
+            v->write("pEmbed", pEmbed);
+            v->write("pReconfMem", pReconfMem);
+            v->write("pWorkers", pWorkers);
+            v->write("pWorkerPrio", pWorkerPrio);
+            v->write("pOffline", pOffline);
+            v->write("pDeadline", pDeadline);
+            v->write("pCpuLoad", pCpuLoad);
+            v->write("pMisses", pMisses);
+            v->write("pReconfigLatency", pReconfigLatency);
+            v->write("pMemory", pMemory);
+            v->write("pMemPeak", pMemPeak);
 
             v->write("pData", pData);
             v->write("pExecutor", pExecutor);
+            v->write("pHostExecutor", pHostExecutor);
+            v->write("pPool", pPool);
         }
 
     } /* namespace plugins */
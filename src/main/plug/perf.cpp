@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/plugins/perf.h>
+
+#ifdef PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif /* PLATFORM_WINDOWS */
+
+namespace lsp
+{
+    namespace plugins
+    {
+        namespace perf
+        {
+            static constexpr float AVG_FACTOR   = 0.01f;    // Weight of the new measurement in the rolling average
+
+            uint64_t now()
+            {
+            #ifdef PLATFORM_WINDOWS
+                LARGE_INTEGER freq, count;
+                ::QueryPerformanceFrequency(&freq);
+                ::QueryPerformanceCounter(&count);
+                return uint64_t((double(count.QuadPart) * 1e+9) / double(freq.QuadPart));
+            #else
+                struct timespec ts;
+                ::clock_gettime(CLOCK_MONOTONIC, &ts);
+                return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+            #endif /* PLATFORM_WINDOWS */
+            }
+
+            void init(timing_t *t)
+            {
+                t->nStart       = 0;
+                t->nLast        = 0;
+                t->nMax         = 0;
+                t->fAvg         = 0.0f;
+                t->nCount       = 0;
+            }
+
+            void commit(timing_t *t, uint64_t duration)
+            {
+                t->nLast        = duration;
+                t->nMax         = lsp_max(t->nMax, duration);
+                t->fAvg         = (t->nCount > 0) ? t->fAvg + (float(duration) - t->fAvg) * AVG_FACTOR : float(duration);
+                ++t->nCount;
+            }
+
+            void dump(dspu::IStateDumper *v, const char *name, const timing_t *t)
+            {
+                if (name != NULL)
+                    v->begin_object(name, t, sizeof(timing_t));
+                else
+                    v->begin_object(t, sizeof(timing_t));
+                {
+                    v->write("nStart", t->nStart);
+                    v->write("nLast", t->nLast);
+                    v->write("nMax", t->nMax);
+                    v->write("fAvg", t->fAvg);
+                    v->write("nCount", t->nCount);
+                }
+                v->end_object();
+            }
+        } /* namespace perf */
+    } /* namespace plugins */
+} /* namespace lsp */
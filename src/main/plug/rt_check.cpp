@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/plugins/rt_check.h>
+
+#ifdef LSP_IR_RT_CHECK
+
+#include <lsp-plug.in/common/debug.h>
+
+#include <errno.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__GLIBC__)
+    #include <dlfcn.h>
+    #include <pthread.h>
+
+    #define IR_RT_CHECK_INTERCEPT
+#endif /* __GLIBC__ */
+
+namespace lsp
+{
+    namespace plugins
+    {
+        namespace rt_check
+        {
+            static thread_local size_t  nDepth      = 0;        // Nesting level of real-time scope
+            static thread_local bool    bReport     = false;    // Violation is currently being reported
+
+            void enter()
+            {
+                ++nDepth;
+            }
+
+            void leave()
+            {
+                if (nDepth > 0)
+                    --nDepth;
+            }
+
+            bool active()
+            {
+                return (nDepth > 0) && (!bReport);
+            }
+
+            void violation(const char *what)
+            {
+                // Logging can allocate memory itself, do not report nested calls
+                bReport     = true;
+                lsp_error("Real-time safety violation: %s called from real-time thread", what);
+                fprintf(stderr, "Real-time safety violation: %s called from real-time thread\n", what);
+                fflush(stderr);
+                abort();
+            }
+        } /* namespace rt_check */
+    } /* namespace plugins */
+} /* namespace lsp */
+
+#ifdef IR_RT_CHECK_INTERCEPT
+
+// Interceptors of memory management and locking routines. They are effective for the code
+// which resolves these symbols to the plugin's binary (standalone builds or builds linked
+// with -Wl,-Bsymbolic-functions).
+extern "C"
+{
+    extern void *__libc_malloc(size_t size);
+    extern void *__libc_calloc(size_t nmemb, size_t size);
+    extern void *__libc_realloc(void *ptr, size_t size);
+    extern void *__libc_memalign(size_t alignment, size_t size);
+    extern void *__libc_valloc(size_t size);
+    extern void *__libc_pvalloc(size_t size);
+    extern void __libc_free(void *ptr);
+
+    #define IR_RT_CHECK_CALL(name) \
+        if (::lsp::plugins::rt_check::active()) \
+            ::lsp::plugins::rt_check::violation(name);
+
+    void *malloc(size_t size)
+    {
+        IR_RT_CHECK_CALL("malloc");
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t nmemb, size_t size)
+    {
+        IR_RT_CHECK_CALL("calloc");
+        return __libc_calloc(nmemb, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        IR_RT_CHECK_CALL("realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        IR_RT_CHECK_CALL("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        IR_RT_CHECK_CALL("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **memptr, size_t alignment, size_t size)
+    {
+        IR_RT_CHECK_CALL("posix_memalign");
+        if ((alignment % sizeof(void *)) || (alignment & (alignment - 1)) || (alignment == 0))
+            return EINVAL;
+        void *ptr = __libc_memalign(alignment, size);
+        if (ptr == NULL)
+            return ENOMEM;
+        *memptr = ptr;
+        return 0;
+    }
+
+    void *valloc(size_t size)
+    {
+        IR_RT_CHECK_CALL("valloc");
+        return __libc_valloc(size);
+    }
+
+    void *pvalloc(size_t size)
+    {
+        IR_RT_CHECK_CALL("pvalloc");
+        return __libc_pvalloc(size);
+    }
+
+    void free(void *ptr)
+    {
+        if (ptr != NULL)
+            IR_RT_CHECK_CALL("free");
+        __libc_free(ptr);
+    }
+
+    typedef int (*pthread_mutex_func_t)(pthread_mutex_t *mutex);
+
+    static pthread_mutex_func_t resolve_mutex_func(const char *name)
+    {
+        return reinterpret_cast<pthread_mutex_func_t>(dlsym(RTLD_NEXT, name));
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t *mutex)
+    {
+        static pthread_mutex_func_t func = resolve_mutex_func("pthread_mutex_lock");
+        IR_RT_CHECK_CALL("pthread_mutex_lock");
+        return func(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t *mutex)
+    {
+        static pthread_mutex_func_t func = resolve_mutex_func("pthread_mutex_trylock");
+        IR_RT_CHECK_CALL("pthread_mutex_trylock");
+        return func(mutex);
+    }
+
+    #undef IR_RT_CHECK_CALL
+} /* extern "C" */
+
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+        abort();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+        abort();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return malloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return malloc(size);
+}
+
+#ifdef __cpp_aligned_new
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    void *ptr = aligned_alloc(size_t(alignment), size);
+    if (ptr == NULL)
+        abort();
+    return ptr;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    void *ptr = aligned_alloc(size_t(alignment), size);
+    if (ptr == NULL)
+        abort();
+    return ptr;
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return aligned_alloc(size_t(alignment), size);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return aligned_alloc(size_t(alignment), size);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+#endif /* __cpp_aligned_new */
+
+#endif /* IR_RT_CHECK_INTERCEPT */
+
+#endif /* LSP_IR_RT_CHECK */
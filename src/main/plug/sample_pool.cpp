@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/plugins/sample_pool.h>
+#include <lsp-plug.in/common/debug.h>
+
+namespace lsp
+{
+    namespace plugins
+    {
+        static constexpr size_t CLASS_GRANULE_MIN   = 0x40;     // Minimum granule of the size class, samples
+        static constexpr size_t CLASS_GRANULE_SHIFT = 3;        // Size class granule relative to the length, 1/8
+
+        SamplePool::SamplePool()
+        {
+            for (size_t i=0; i<ITEMS_MAX; ++i)
+                vItems[i]       = NULL;
+            nItems          = 0;
+            nBytes          = 0;
+            nLimit          = 0;
+            nRequests       = 0;
+            nHits           = 0;
+            nEvicted        = 0;
+        }
+
+        SamplePool::~SamplePool()
+        {
+            destroy();
+        }
+
+        void SamplePool::destroy()
+        {
+            clear();
+        }
+
+        size_t SamplePool::size_class(size_t length)
+        {
+            // Round the length up to 1/8 of its highest power of two, this keeps the
+            // overhead within 12.5% while allowing to reuse samples of close lengths
+            size_t granule  = CLASS_GRANULE_MIN;
+            while ((granule << (CLASS_GRANULE_SHIFT + 1)) <= length)
+                granule       <<= 1;
+
+            return (length + granule - 1) & (~(granule - 1));
+        }
+
+        size_t SamplePool::sample_bytes(const dspu::Sample *s)
+        {
+            return s->channels() * s->max_length() * sizeof(float);
+        }
+
+        void SamplePool::free_sample(dspu::Sample *s)
+        {
+            s->destroy();
+            delete s;
+        }
+
+        void SamplePool::evict(size_t index)
+        {
+            dspu::Sample *s = vItems[index];
+            nBytes         -= sample_bytes(s);
+            --nItems;
+            for (size_t i=index; i<nItems; ++i)
+                vItems[i]       = vItems[i+1];
+            vItems[nItems]  = NULL;
+
+            free_sample(s);
+        }
+
+        void SamplePool::set_limit(size_t limit)
+        {
+            nLimit          = limit;
+            while ((nItems > 0) && (nBytes > nLimit))
+            {
+                evict(0);
+                ++nEvicted;
+            }
+        }
+
+        dspu::Sample *SamplePool::alloc(size_t channels, size_t length)
+        {
+            ++nRequests;
+
+            // Find the smallest recycled sample of the same size class
+            const size_t capacity   = size_class(length);
+            ssize_t index           = -1;
+            for (size_t i=0; i<nItems; ++i)
+            {
+                const dspu::Sample *s   = vItems[i];
+                if ((s->channels() != channels) || (s->max_length() < length) || (s->max_length() > capacity))
+                    continue;
+                if ((index < 0) || (s->max_length() < vItems[index]->max_length()))
+                    index                   = i;
+            }
+
+            if (index >= 0)
+            {
+                dspu::Sample *s         = vItems[index];
+                nBytes                 -= sample_bytes(s);
+                --nItems;
+                for (size_t i=index; i<nItems; ++i)
+                    vItems[i]               = vItems[i+1];
+                vItems[nItems]          = NULL;
+
+                s->set_length(length);
+                ++nHits;
+                return s;
+            }
+
+            // Allocate new sample of the size class
+            dspu::Sample *s         = new dspu::Sample();
+            if (s == NULL)
+                return NULL;
+            if (!s->init(channels, capacity, length))
+            {
+                free_sample(s);
+                return NULL;
+            }
+
+            return s;
+        }
+
+        void SamplePool::release(dspu::Sample * &s)
+        {
+            if (s == NULL)
+                return;
+
+            dspu::Sample *item  = s;
+            s                   = NULL;
+
+            // Drop samples which can not be recycled
+            const size_t bytes  = sample_bytes(item);
+            if ((item->channels() <= 0) || (bytes > nLimit))
+            {
+                free_sample(item);
+                return;
+            }
+
+            // Free the oldest samples to stay within limits
+            while ((nItems > 0) && ((nItems >= ITEMS_MAX) || (nBytes + bytes > nLimit)))
+            {
+                evict(0);
+                ++nEvicted;
+            }
+
+            item->set_length(0);
+            vItems[nItems++]    = item;
+            nBytes             += bytes;
+        }
+
+        void SamplePool::clear()
+        {
+            while (nItems > 0)
+                evict(nItems - 1);
+        }
+
+        void SamplePool::dump(dspu::IStateDumper *v) const
+        {
+            v->begin_array("vItems", vItems, nItems);
+            {
+                for (size_t i=0; i<nItems; ++i)
+                    v->write_object(vItems[i]);
+            }
+            v->end_array();
+
+            v->write("nItems", nItems);
+            v->write("nBytes", nBytes);
+            v->write("nLimit", nLimit);
+            v->write("nRequests", nRequests);
+            v->write("nHits", nHits);
+            v->write("nEvicted", nEvicted);
+        }
+    } /* namespace plugins */
+} /* namespace lsp */
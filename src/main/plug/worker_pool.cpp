@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/plugins/worker_pool.h>
+#include <lsp-plug.in/common/atomic.h>
+#include <lsp-plug.in/common/debug.h>
+#include <lsp-plug.in/common/finally.h>
+
+#if defined(PLATFORM_LINUX)
+    #include <errno.h>
+    #include <sched.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif /* PLATFORM_LINUX */
+
+namespace lsp
+{
+    namespace plugins
+    {
+        static constexpr size_t IDLE_WAIT       = 100;      // Maximum wait of idle worker for the next task, ms
+        static constexpr size_t IDLE_POLL       = 5;        // Delay between polls of idle worker without semaphore, ms
+        static constexpr size_t DETACH_WAIT     = 1;        // Delay between checks of running tasks on detach, ms
+        static constexpr int    NICE_LOW        = 10;       // Nice value of low priority workers
+
+        //---------------------------------------------------------------------
+        WorkerQueue::WorkerQueue()
+        {
+            for (size_t i=0; i<CAPACITY; ++i)
+                vTasks[i]       = NULL;
+            nHead           = 0;
+            nTail           = 0;
+            nRunning        = 0;
+            nThreads        = 0;
+            nPriority       = WP_NORMAL;
+            pNext           = NULL;
+            pPool           = NULL;
+        }
+
+        WorkerQueue::~WorkerQueue()
+        {
+            shutdown();
+        }
+
+        bool WorkerQueue::submit(ipc::ITask *task)
+        {
+            if ((pPool == NULL) || (!task->idle()))
+                return false;
+
+            // Only the real-time thread submits tasks, the ring is full when all slots are taken
+            const uatomic_t tail    = nTail;
+            if ((tail - nHead) >= CAPACITY)
+                return false;
+
+            change_task_state(task, ipc::ITask::TS_SUBMITTED);
+            vTasks[tail % CAPACITY] = task;
+            atomic_add(&nTail, 1);
+            pPool->post_task();
+
+            return true;
+        }
+
+        void WorkerQueue::shutdown()
+        {
+            if (pPool != NULL)
+                pPool->detach(this);
+        }
+
+        ipc::ITask *WorkerQueue::take()
+        {
+            // Called by the pool under the lock, so there is only one consumer at a time
+            const uatomic_t head    = nHead;
+            if (head == atomic_add(&nTail, 0))
+                return NULL;
+
+            ipc::ITask *task        = vTasks[head % CAPACITY];
+            vTasks[head % CAPACITY] = NULL;
+            atomic_add(&nRunning, 1);
+            atomic_add(&nHead, 1);
+
+            return task;
+        }
+
+        void WorkerQueue::execute(ipc::ITask *task)
+        {
+            run_task(task);
+            atomic_add(&nRunning, -1);
+        }
+
+        void WorkerQueue::drop()
+        {
+            // Called by the pool under the lock, dropped tasks become idle and can be submitted again
+            const uatomic_t tail    = atomic_add(&nTail, 0);
+            for (uatomic_t i=nHead; i != tail; ++i)
+            {
+                ipc::ITask *task        = vTasks[i % CAPACITY];
+                vTasks[i % CAPACITY]    = NULL;
+                change_task_state(task, ipc::ITask::TS_IDLE);
+            }
+            nHead           = tail;
+        }
+
+        bool WorkerQueue::remove(ipc::ITask *task)
+        {
+            // Called by the pool under the lock from the thread that submits tasks, so the ring does not change
+            const uatomic_t tail    = nTail;
+            for (uatomic_t i=nHead; i != tail; ++i)
+            {
+                if (vTasks[i % CAPACITY] != task)
+                    continue;
+
+                // Shift the tasks submitted later to keep the order of execution
+                for (uatomic_t j=i+1; j != tail; ++j)
+                    vTasks[(j - 1) % CAPACITY]  = vTasks[j % CAPACITY];
+                vTasks[(tail - 1) % CAPACITY]   = NULL;
+                atomic_add(&nTail, -1);
+                change_task_state(task, ipc::ITask::TS_IDLE);
+
+                return true;
+            }
+
+            return false;
+        }
+
+        bool WorkerQueue::withdraw(ipc::ITask *task)
+        {
+            return (pPool != NULL) ? pPool->withdraw(this, task) : false;
+        }
+
+        void WorkerQueue::dump(dspu::IStateDumper *v) const
+        {
+            v->writev("vTasks", vTasks, CAPACITY);
+            v->write("nHead", nHead);
+            v->write("nTail", nTail);
+            v->write("nRunning", nRunning);
+            v->write("nThreads", nThreads);
+            v->write("nPriority", nPriority);
+            v->write("pNext", pNext);
+            v->write("pPool", pPool);
+        }
+
+        //---------------------------------------------------------------------
+        WorkerPool::Worker::Worker(WorkerPool *pool)
+        {
+            pPool           = pool;
+            bStop           = false;
+            nPriority       = WP_NORMAL;
+        }
+
+        WorkerPool::Worker::~Worker()
+        {
+            pPool           = NULL;
+        }
+
+        status_t WorkerPool::Worker::run()
+        {
+            while (!bStop)
+            {
+                // Apply the requested priority
+                const size_t priority   = pPool->nPriority;
+                if (priority != nPriority)
+                {
+                    apply_priority(priority);
+                    nPriority               = priority;
+                }
+
+                // Execute the next task
+                WorkerQueue *queue      = NULL;
+                ipc::ITask *task        = pPool->next_task(&queue);
+                if (task != NULL)
+                {
+                    queue->execute(task);
+                    continue;
+                }
+
+                // Nothing to do, wait for the next submitted task
+                pPool->wait_task();
+            }
+
+            return STATUS_OK;
+        }
+
+        //---------------------------------------------------------------------
+        WorkerPool     *WorkerPool::pInstance       = NULL;
+        ipc::Mutex      WorkerPool::sInstanceLock;
+
+        WorkerPool::WorkerPool()
+        {
+            pQueues         = NULL;
+            pCursor         = NULL;
+            for (size_t i=0; i<THREADS_MAX; ++i)
+                vWorkers[i]     = NULL;
+            nWorkers        = 0;
+            nPriority       = WP_NORMAL;
+            nReferences     = 0;
+        #if defined(PLATFORM_LINUX)
+            sem_init(&hTasks, 0, 0);
+        #endif /* PLATFORM_LINUX */
+        }
+
+        WorkerPool::~WorkerPool()
+        {
+            Worker *stopped[THREADS_MAX];
+            join_workers(stopped, resize(0, false, stopped));
+        #if defined(PLATFORM_LINUX)
+            sem_destroy(&hTasks);
+        #endif /* PLATFORM_LINUX */
+        }
+
+        WorkerPool *WorkerPool::acquire()
+        {
+            if (!sInstanceLock.lock())
+                return NULL;
+            lsp_finally { sInstanceLock.unlock(); };
+
+            if (pInstance == NULL)
+            {
+                pInstance   = new WorkerPool();
+                if (pInstance == NULL)
+                    return NULL;
+                lsp_trace("Created worker pool %p", pInstance);
+            }
+
+            ++pInstance->nReferences;
+            return pInstance;
+        }
+
+        void WorkerPool::release()
+        {
+            if (!sInstanceLock.lock())
+                return;
+
+            const bool last     = (--nReferences) <= 0;
+            if ((last) && (pInstance == this))
+                pInstance   = NULL;
+            sInstanceLock.unlock();
+
+            // The pool is not visible to other instances anymore, so the workers are joined without the lock
+            if (!last)
+                return;
+            lsp_trace("Destroying worker pool %p", this);
+            delete this;
+        }
+
+        void WorkerPool::apply_priority(size_t priority)
+        {
+        #if defined(PLATFORM_LINUX)
+            const pid_t tid     = pid_t(syscall(SYS_gettid));
+
+            // Idle scheduling policy runs the thread only when the CPU has nothing else to do
+            struct sched_param param;
+            param.sched_priority    = 0;
+            if (sched_setscheduler(tid, (priority == WP_IDLE) ? SCHED_IDLE : SCHED_OTHER, &param) != 0)
+                lsp_warn("Could not set scheduling policy of worker thread");
+
+            const int value     = (priority == WP_NORMAL) ? 0 : NICE_LOW;
+            if (setpriority(PRIO_PROCESS, id_t(tid), value) != 0)
+                lsp_warn("Could not set priority of worker thread");
+        #else
+            (void)priority;
+        #endif /* PLATFORM_LINUX */
+        }
+
+        void WorkerPool::wait_task()
+        {
+        #if defined(PLATFORM_LINUX)
+            // The timeout only limits the time the stopped worker needs to notice the stop request
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec     += (IDLE_WAIT % 1000) * 1000000;
+            ts.tv_sec      += IDLE_WAIT / 1000 + ts.tv_nsec / 1000000000;
+            ts.tv_nsec     %= 1000000000;
+
+            while ((sem_timedwait(&hTasks, &ts) != 0) && (errno == EINTR))
+                /* Restart the wait */ ;
+        #else
+            ipc::Thread::sleep(IDLE_POLL);
+        #endif /* PLATFORM_LINUX */
+        }
+
+        void WorkerPool::post_task()
+        {
+            // Posting the semaphore does not block, so it can be called from the real-time thread
+        #if defined(PLATFORM_LINUX)
+            sem_post(&hTasks);
+        #endif /* PLATFORM_LINUX */
+        }
+
+        void WorkerPool::configure(WorkerQueue *queue, size_t threads, worker_priority_t priority)
+        {
+            // Workers take the queue lock, so serialize configuration with the instance lock
+            Worker *stopped[THREADS_MAX];
+            if (!sInstanceLock.lock())
+                return;
+
+            queue->nThreads     = threads;
+            queue->nPriority    = priority;
+            const size_t count  = update(stopped);
+            sInstanceLock.unlock();
+
+            // Wait for the stopped workers without blocking other instances
+            join_workers(stopped, count);
+        }
+
+        size_t WorkerPool::update(Worker **stopped)
+        {
+            // Use the maximum number of threads and the highest priority requested by attached queues
+            size_t threads      = 0;
+            size_t priority     = WP_IDLE;
+            if (!sLock.lock())
+                return 0;
+            for (WorkerQueue *q = pQueues; q != NULL; q = q->pNext)
+            {
+                threads             = lsp_max(threads, q->nThreads);
+                priority            = lsp_min(priority, q->nPriority);
+            }
+            sLock.unlock();
+
+            // Without privileges the running workers can lower their priority but can not raise it back,
+            // so the workers are replaced by new threads that start with the priority of the host
+            const bool restart  = priority < nPriority;
+            nPriority           = priority;
+            return resize(lsp_min(threads, THREADS_MAX), restart, stopped);
+        }
+
+        size_t WorkerPool::resize(size_t threads, bool restart, Worker **stopped)
+        {
+            size_t count        = 0;
+
+            // Stop extra workers, they finish the current task first and are joined by the caller
+            const size_t keep   = (restart) ? 0 : threads;
+            while (nWorkers > keep)
+            {
+                Worker *w       = vWorkers[--nWorkers];
+                vWorkers[nWorkers]      = NULL;
+                w->stop();
+                post_task();
+                stopped[count++]        = w;
+            }
+
+            // Start new workers
+            while (nWorkers < threads)
+            {
+                Worker *w       = new Worker(this);
+                if (w == NULL)
+                    break;
+                if (w->start() != STATUS_OK)
+                {
+                    delete w;
+                    break;
+                }
+                vWorkers[nWorkers++]    = w;
+            }
+
+            return count;
+        }
+
+        void WorkerPool::join_workers(Worker **stopped, size_t count)
+        {
+            for (size_t i=0; i<count; ++i)
+            {
+                Worker *w       = stopped[i];
+                w->join();
+                delete w;
+            }
+        }
+
+        ipc::ITask *WorkerPool::next_task(WorkerQueue **queue)
+        {
+            if (!sLock.lock())
+                return NULL;
+            lsp_finally { sLock.unlock(); };
+
+            // Visit the queues in round-robin order starting from the cursor
+            WorkerQueue *q  = (pCursor != NULL) ? pCursor : pQueues;
+            for (WorkerQueue *first = q; q != NULL; )
+            {
+                WorkerQueue *next   = (q->pNext != NULL) ? q->pNext : pQueues;
+                ipc::ITask *task    = q->take();
+                if (task != NULL)
+                {
+                    pCursor             = next;
+                    *queue              = q;
+                    return task;
+                }
+
+                q                   = (next != first) ? next : NULL;
+            }
+
+            return NULL;
+        }
+
+        bool WorkerPool::withdraw(WorkerQueue *queue, ipc::ITask *task)
+        {
+            if (!sLock.lock())
+                return false;
+            lsp_finally { sLock.unlock(); };
+
+            return queue->remove(task);
+        }
+
+        void WorkerPool::attach(WorkerQueue *queue)
+        {
+            if (!sLock.lock())
+                return;
+            lsp_finally { sLock.unlock(); };
+
+            queue->pPool    = this;
+            queue->pNext    = pQueues;
+            pQueues         = queue;
+        }
+
+        void WorkerPool::detach(WorkerQueue *queue)
+        {
+            if (sLock.lock())
+            {
+                lsp_finally { sLock.unlock(); };
+
+                // Remove queue from the list
+                for (WorkerQueue **q = &pQueues; *q != NULL; q = &(*q)->pNext)
+                {
+                    if (*q != queue)
+                        continue;
+                    *q              = queue->pNext;
+                    break;
+                }
+                if (pCursor == queue)
+                    pCursor         = pQueues;
+
+                // Drop tasks which have not been started
+                queue->drop();
+                queue->pNext    = NULL;
+                queue->pPool    = NULL;
+            }
+
+            // Wait for the tasks which are being executed
+            while (queue->nRunning > 0)
+                ipc::Thread::sleep(DETACH_WAIT);
+
+            // The requests of the detached queue are not taken into account anymore
+            Worker *stopped[THREADS_MAX];
+            if (!sInstanceLock.lock())
+                return;
+            const size_t count  = update(stopped);
+            sInstanceLock.unlock();
+
+            join_workers(stopped, count);
+        }
+    } /* namespace plugins */
+} /* namespace lsp */
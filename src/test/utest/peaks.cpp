@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/finally.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+#include <private/meta/impulse_reverb.h>
+#include <private/plugins/impulse_reverb.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace lsp
+{
+    namespace peaks
+    {
+        static constexpr size_t PEAK_BLOCK      = 0x100;    // Should match the block size of the plugin
+        static constexpr size_t MESH_SIZE       = meta::impulse_reverb_metadata::MESH_SIZE;
+
+        class Reverb: public plugins::impulse_reverb
+        {
+            public:
+                using plugins::impulse_reverb::af_descriptor_t;
+                using plugins::impulse_reverb::peaks_t;
+                using plugins::impulse_reverb::init_peaks;
+                using plugins::impulse_reverb::destroy_peaks;
+                using plugins::impulse_reverb::update_peak_blocks;
+                using plugins::impulse_reverb::update_peaks;
+
+            public:
+                explicit Reverb(): plugins::impulse_reverb(&meta::impulse_reverb_mono) {}
+        };
+
+        static float naive_peak(const float *src, size_t length, size_t first, size_t last)
+        {
+            float peak          = 0.0f;
+            for (size_t i=first * PEAK_BLOCK; (i < last * PEAK_BLOCK) && (i < length); ++i)
+                peak                = lsp_max(peak, fabsf(src[i]));
+            return peak;
+        }
+    } /* namespace peaks */
+} /* namespace lsp */
+
+UTEST_BEGIN("impulse_reverb", peaks)
+
+    void fill(dspu::Sample *s)
+    {
+        for (size_t i=0; i<s->channels(); ++i)
+        {
+            float *dst      = s->channel(i);
+            for (size_t j=0; j<s->length(); ++j)
+                dst[j]          = (float(rand()) / RAND_MAX - 0.5f) * expf(-float(j) * 1e-5f);
+        }
+    }
+
+    void check_pyramid(const peaks::Reverb::peaks_t *p, dspu::Sample *s)
+    {
+        const size_t blocks = (s->length() + peaks::PEAK_BLOCK - 1) / peaks::PEAK_BLOCK;
+        UTEST_ASSERT(p->vData != NULL);
+        UTEST_ASSERT(p->nChannels == s->channels());
+        UTEST_ASSERT(p->nLength == s->length());
+        UTEST_ASSERT(p->nBlocks == blocks);
+
+        for (size_t i=0; i<s->channels(); ++i)
+        {
+            const float *src    = s->channel(i);
+            const float *level  = &p->vData[i * p->nStride];
+            size_t stride       = 0;
+
+            // Each value of the level covers (1 << k) blocks of the finest level
+            for (size_t k=0, n=blocks; ; ++k)
+            {
+                for (size_t j=0; j<n; ++j)
+                {
+                    const float exp     = peaks::naive_peak(src, s->length(), j << k, (j + 1) << k);
+                    UTEST_ASSERT_MSG(level[j] == exp,
+                        "channel=%d, level=%d, block=%d: got %g, expected %g",
+                        int(i), int(k), int(j), level[j], exp);
+                }
+
+                stride             += n;
+                level              += n;
+                if (((n + 1) / 2) < peaks::MESH_SIZE)
+                    break;
+                n                   = (n + 1) / 2;
+            }
+
+            UTEST_ASSERT(stride == p->nStride);
+        }
+    }
+
+    UTEST_MAIN
+    {
+        dsp::init();
+
+        peaks::Reverb r;
+        peaks::Reverb::af_descriptor_t f;
+        peaks::Reverb::init_peaks(&f.sPeaks);
+        lsp_finally { peaks::Reverb::destroy_peaks(&f.sPeaks); };
+        f.nSourceGen        = 1;
+        f.bReverse          = false;
+
+        // Short samples do not need the pyramid
+        dspu::Sample s;
+        UTEST_ASSERT(s.init(2, peaks::PEAK_BLOCK * peaks::MESH_SIZE, peaks::PEAK_BLOCK * (peaks::MESH_SIZE - 1)));
+        fill(&s);
+        UTEST_ASSERT(r.update_peaks(&f, &s, 0, 0, 0, 0) == STATUS_OK);
+        UTEST_ASSERT(f.sPeaks.vData == NULL);
+
+        // Three levels with odd number of blocks and the last partial block
+        const size_t length = peaks::PEAK_BLOCK * peaks::MESH_SIZE * 4 + 17;
+        s.destroy();
+        UTEST_ASSERT(s.init(2, length, length));
+        fill(&s);
+        UTEST_ASSERT(r.update_peaks(&f, &s, 0, 0, 0, 0) == STATUS_OK);
+        check_pyramid(&f.sPeaks, &s);
+
+        // Fades update only the affected blocks
+        const size_t fade_in    = peaks::PEAK_BLOCK * 5 + 3;
+        const size_t fade_out   = peaks::PEAK_BLOCK * 7 + 11;
+        for (size_t i=0; i<s.channels(); ++i)
+        {
+            float *dst          = s.channel(i);
+            for (size_t j=0; j<fade_in; ++j)
+                dst[j]             *= float(j) / fade_in;
+            for (size_t j=0; j<fade_out; ++j)
+                dst[length - j - 1]*= float(j) / fade_out;
+        }
+        UTEST_ASSERT(r.update_peaks(&f, &s, 0, 0, fade_in, fade_out) == STATUS_OK);
+        UTEST_ASSERT(f.sPeaks.nFadeIn == fade_in);
+        UTEST_ASSERT(f.sPeaks.nFadeOut == fade_out);
+        check_pyramid(&f.sPeaks, &s);
+
+        // Nothing changed, the pyramid is kept
+        const float *data   = f.sPeaks.vData;
+        const float middle  = data[peaks::MESH_SIZE];
+        s.channel(0)[peaks::MESH_SIZE * peaks::PEAK_BLOCK] = 10.0f;
+        UTEST_ASSERT(r.update_peaks(&f, &s, 0, 0, fade_in, fade_out) == STATUS_OK);
+        UTEST_ASSERT(f.sPeaks.vData == data);
+        UTEST_ASSERT(f.sPeaks.vData[peaks::MESH_SIZE] == middle);
+
+        // New source data rebuilds the whole pyramid
+        ++f.nSourceGen;
+        UTEST_ASSERT(r.update_peaks(&f, &s, 0, 0, fade_in, fade_out) == STATUS_OK);
+        UTEST_ASSERT(f.sPeaks.vData[peaks::MESH_SIZE] == 10.0f);
+        check_pyramid(&f.sPeaks, &s);
+
+        // Update of the single block
+        float *src          = s.channel(1);
+        src[length - 1]     = -20.0f;
+        peaks::Reverb::update_peak_blocks(&f.sPeaks, &s, f.sPeaks.nBlocks - 1, f.sPeaks.nBlocks);
+        UTEST_ASSERT(f.sPeaks.vData[f.sPeaks.nStride + f.sPeaks.nBlocks - 1] == 20.0f);
+        UTEST_ASSERT(f.sPeaks.vData[f.sPeaks.nBlocks - 1] == peaks::naive_peak(s.channel(0), length, f.sPeaks.nBlocks - 1, f.sPeaks.nBlocks));
+    }
+
+UTEST_END
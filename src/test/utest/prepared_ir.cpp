@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/endian.h>
+#include <lsp-plug.in/common/finally.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+#include <private/plugins/impulse_reverb.h>
+#include <private/plugins/prepared_ir.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace lsp
+{
+    namespace prepared_ir
+    {
+        static constexpr size_t CHANNELS        = 3;
+        static constexpr size_t LENGTH          = 1000;
+        static constexpr size_t PADDING         = 16;
+
+        class Reverb: public plugins::impulse_reverb
+        {
+            public:
+                using plugins::impulse_reverb::load_prepared;
+        };
+    } /* namespace prepared_ir */
+} /* namespace lsp */
+
+UTEST_BEGIN("impulse_reverb", prepared_ir)
+
+    void init_header(plugins::prepared_ir_header_t *hdr)
+    {
+        memcpy(hdr->vSignature, "LIRP", 4);
+        hdr->nVersion       = plugins::PREPARED_IR_VERSION;
+        hdr->nHeaderSize    = sizeof(plugins::prepared_ir_header_t) + prepared_ir::PADDING;
+        hdr->nChannels      = prepared_ir::CHANNELS;
+        hdr->nLength        = prepared_ir::LENGTH;
+        hdr->nSampleRate    = 48000;
+        hdr->fPeak          = 0.75f;
+        hdr->fGate          = -60.0f;
+        hdr->fFadeOut       = 10.0f;
+    }
+
+    void write_file(const char *path, const plugins::prepared_ir_header_t *hdr, size_t hdr_size, const float *data, size_t count)
+    {
+        FILE *fd = fopen(path, "wb");
+        UTEST_ASSERT(fd != NULL);
+        lsp_finally { fclose(fd); };
+
+        // The file is little-endian
+        plugins::prepared_ir_header_t le = *hdr;
+        le.nVersion         = CPU_TO_LE(hdr->nVersion);
+        le.nHeaderSize      = CPU_TO_LE(hdr->nHeaderSize);
+        le.nChannels        = CPU_TO_LE(hdr->nChannels);
+        le.nLength          = CPU_TO_LE(hdr->nLength);
+        le.nSampleRate      = CPU_TO_LE(hdr->nSampleRate);
+        le.fPeak            = CPU_TO_LE(hdr->fPeak);
+        le.fGate            = CPU_TO_LE(hdr->fGate);
+        le.fFadeOut         = CPU_TO_LE(hdr->fFadeOut);
+
+        uint8_t buf[sizeof(plugins::prepared_ir_header_t) + prepared_ir::PADDING];
+        memset(buf, 0xff, sizeof(buf));
+        memcpy(buf, &le, lsp_min(hdr_size, sizeof(plugins::prepared_ir_header_t)));
+
+        UTEST_ASSERT(fwrite(buf, 1, hdr_size, fd) == hdr_size);
+        for (size_t i=0; i<count; ++i)
+        {
+            const float v       = CPU_TO_LE(data[i]);
+            UTEST_ASSERT(fwrite(&v, sizeof(float), 1, fd) == 1);
+        }
+    }
+
+    status_t load(dspu::Sample *s, float *peak, size_t *channels, const char *path, size_t mask)
+    {
+        s->destroy();
+        *peak       = 0.0f;
+        *channels   = 0;
+        return prepared_ir::Reverb::load_prepared(s, peak, channels, path, mask);
+    }
+
+    UTEST_MAIN
+    {
+        char path[PATH_MAX];
+        snprintf(path, PATH_MAX, "%s/utest-%s.lir", tempdir(), full_name());
+        lsp_finally { remove(path); };
+
+        // Planar data, each sample encodes the track and the offset
+        float data[prepared_ir::CHANNELS * prepared_ir::LENGTH];
+        for (size_t i=0; i<prepared_ir::CHANNELS; ++i)
+            for (size_t j=0; j<prepared_ir::LENGTH; ++j)
+                data[i * prepared_ir::LENGTH + j] = float(i + 1) + float(j) * 1e-4f;
+
+        plugins::prepared_ir_header_t hdr;
+        const size_t hdr_size = sizeof(hdr) + prepared_ir::PADDING;
+        dspu::Sample s;
+        float peak;
+        size_t channels;
+
+        // All tracks, the data starts after the extended header
+        init_header(&hdr);
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_OK);
+        UTEST_ASSERT(peak == 0.75f);
+        UTEST_ASSERT(channels == prepared_ir::CHANNELS);
+        UTEST_ASSERT(s.channels() == prepared_ir::CHANNELS);
+        UTEST_ASSERT(s.length() == prepared_ir::LENGTH);
+        UTEST_ASSERT(s.sample_rate() == 48000);
+        for (size_t i=0; i<prepared_ir::CHANNELS; ++i)
+            UTEST_ASSERT_MSG(memcmp(s.channel(i), &data[i * prepared_ir::LENGTH], prepared_ir::LENGTH * sizeof(float)) == 0,
+                "Track %d does not match", int(i));
+
+        // Only the selected tracks are read, the number of tracks in the file is reported
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x5) == STATUS_OK);
+        UTEST_ASSERT(channels == prepared_ir::CHANNELS);
+        UTEST_ASSERT(s.channels() == 2);
+        UTEST_ASSERT(memcmp(s.channel(0), &data[0], prepared_ir::LENGTH * sizeof(float)) == 0);
+        UTEST_ASSERT(memcmp(s.channel(1), &data[2 * prepared_ir::LENGTH], prepared_ir::LENGTH * sizeof(float)) == 0);
+
+        // No tracks selected
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x8) == STATUS_BAD_FORMAT);
+
+        // Truncated data
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH - 1);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_CORRUPTED);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x3) == STATUS_OK);
+
+        // Truncated header
+        write_file(path, &hdr, 10, NULL, 0);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_BAD_FORMAT);
+
+        // Bad signature
+        hdr.vSignature[3]   = 'X';
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_BAD_FORMAT);
+
+        // Unsupported version and header size
+        init_header(&hdr);
+        hdr.nVersion        = plugins::PREPARED_IR_VERSION + 1;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_UNSUPPORTED_FORMAT);
+
+        init_header(&hdr);
+        hdr.nHeaderSize     = sizeof(hdr) - 4;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_UNSUPPORTED_FORMAT);
+
+        // Invalid parameters
+        init_header(&hdr);
+        hdr.nChannels       = 0;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_CORRUPTED);
+
+        init_header(&hdr);
+        hdr.nSampleRate     = 0;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) == STATUS_CORRUPTED);
+
+        // Malformed number of tracks, the mask should not be shifted by it
+        init_header(&hdr);
+        hdr.nChannels       = 0x40000000;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, ~size_t(0)) == STATUS_UNSUPPORTED_FORMAT);
+
+        init_header(&hdr);
+        hdr.nChannels       = meta::impulse_reverb_metadata::TRACKS_MAX + 1;
+        write_file(path, &hdr, hdr_size, data, prepared_ir::CHANNELS * prepared_ir::LENGTH);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x1) == STATUS_UNSUPPORTED_FORMAT);
+
+        // Missing file
+        remove(path);
+        UTEST_ASSERT(load(&s, &peak, &channels, path, 0x7) != STATUS_OK);
+    }
+
+UTEST_END
@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/common/finally.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/ipc/IExecutor.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/mm/OutAudioFileStream.h>
+#include <lsp-plug.in/plug-fw/meta/func.h>
+#include <private/meta/impulse_reverb.h>
+#include <private/plugins/impulse_reverb.h>
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stress test which rapidly changes files, FFT rank and routing of the plugin while processing audio,
+// and the check that convolvers do not play the signal of their previous activation.
+// Configure the build with RT_CHECK=1 to abort the test on any real-time safety violation.
+namespace lsp
+{
+    namespace rt_stress
+    {
+        static constexpr size_t SAMPLE_RATE     = 48000;
+        static constexpr size_t BLOCK_SIZE      = 0x800;
+        static constexpr size_t TASKS_MAX       = 0x10;
+        static constexpr size_t STEPS           = 0x1000;
+        static constexpr size_t SETTLE_BLOCKS   = 0x4000;
+        static constexpr size_t IR_FILES        = 3;
+        static constexpr size_t TAIL_BLOCKS     = 0x20;     // Number of blocks which is longer than any IR file
+        static constexpr float SILENCE          = 1e-5f;    // Maximum output level considered as silence
+
+        class Executor: public ipc::IExecutor
+        {
+            private:
+                ipc::ITask     *vTasks[TASKS_MAX];
+                size_t          nTasks;
+
+            public:
+                explicit Executor()
+                {
+                    for (size_t i=0; i<TASKS_MAX; ++i)
+                        vTasks[i]       = NULL;
+                    nTasks          = 0;
+                }
+
+            public:
+                virtual bool submit(ipc::ITask *task) override
+                {
+                    if ((nTasks >= TASKS_MAX) || (!task->idle()))
+                        return false;
+
+                    change_task_state(task, ipc::ITask::TS_SUBMITTED);
+                    vTasks[nTasks++]    = task;
+                    return true;
+                }
+
+                virtual void shutdown() override
+                {
+                    run_tasks();
+                }
+
+                void run_tasks()
+                {
+                    for (size_t i=0; i<nTasks; ++i)
+                    {
+                        run_task(vTasks[i]);
+                        vTasks[i]           = NULL;
+                    }
+                    nTasks          = 0;
+                }
+        };
+
+        class Wrapper: public plug::IWrapper
+        {
+            private:
+                Executor       *pExecutor;
+
+            public:
+                explicit Wrapper(plug::Module *plugin, Executor *executor): plug::IWrapper(plugin, NULL)
+                {
+                    pExecutor       = executor;
+                }
+
+            public:
+                virtual ipc::IExecutor *executor() override     { return pExecutor; }
+        };
+
+        class Path: public plug::path_t
+        {
+            private:
+                enum state_t
+                {
+                    PS_IDLE,
+                    PS_PENDING,
+                    PS_ACCEPTED
+                };
+
+            private:
+                const char     *sPath;
+                size_t          nState;
+
+            public:
+                explicit Path()
+                {
+                    sPath           = "";
+                    nState          = PS_IDLE;
+                }
+
+            public:
+                virtual void init() override                    { nState = PS_IDLE;                 }
+                virtual const char *path() const override       { return sPath;                     }
+                virtual size_t flags() const override           { return 0;                         }
+                virtual void accept() override                  { nState = PS_ACCEPTED;             }
+                virtual void commit() override                  { nState = PS_IDLE;                 }
+                virtual bool pending() override                 { return nState == PS_PENDING;      }
+                virtual bool accepted() override                { return nState == PS_ACCEPTED;     }
+
+                void submit(const char *path)
+                {
+                    sPath           = path;
+                    nState          = PS_PENDING;
+                }
+        };
+
+        class Port: public plug::IPort
+        {
+            private:
+                float           fValue;
+                float          *pBuffer;
+                Path            sPath;
+
+            public:
+                explicit Port(const meta::port_t *meta): plug::IPort(meta)
+                {
+                    fValue          = meta->start;
+                    pBuffer         = NULL;
+                }
+
+            public:
+                virtual float value() override                  { return fValue;                    }
+                virtual void set_value(float value) override    { fValue = value;                   }
+                virtual void *buffer() override
+                {
+                    return (meta::is_path_port(metadata())) ? static_cast<void *>(&sPath) : pBuffer;
+                }
+
+                inline void bind(float *buf)                    { pBuffer = buf;                    }
+                inline void submit(const char *path)            { sPath.submit(path);               }
+        };
+
+        /**
+         * Host which runs the plugin instance, loading tasks are executed between the calls
+         * of process() unless the plugin runs them on its own worker pool
+         */
+        class Host
+        {
+            private:
+                plugins::impulse_reverb    *pPlugin;
+                Wrapper                    *pWrapper;
+                Executor                    sExecutor;
+                plug::IPort               **vPorts;
+                size_t                      nPorts;
+                Port                       *vAudio[4];
+                float                      *vBuffers[4];
+                uint8_t                    *pData;
+
+            public:
+                explicit Host()
+                {
+                    pPlugin         = NULL;
+                    pWrapper        = NULL;
+                    vPorts          = NULL;
+                    nPorts          = 0;
+                    pData           = NULL;
+                    for (size_t i=0; i<4; ++i)
+                    {
+                        vAudio[i]       = NULL;
+                        vBuffers[i]     = NULL;
+                    }
+                }
+
+                Host(const Host &) = delete;
+                Host(Host &&) = delete;
+                Host & operator = (const Host &) = delete;
+                Host & operator = (Host &&) = delete;
+
+                ~Host()
+                {
+                    if (pPlugin != NULL)
+                    {
+                        pPlugin->deactivate();
+                        sExecutor.run_tasks();
+                        pPlugin->destroy();
+                        delete pPlugin;
+                    }
+                    if (pWrapper != NULL)
+                        delete pWrapper;
+                    if (vPorts != NULL)
+                    {
+                        for (size_t i=0; i<nPorts; ++i)
+                            delete vPorts[i];
+                        free(vPorts);
+                    }
+                    free_aligned(pData);
+                }
+
+            public:
+                status_t init(const meta::plugin_t *meta)
+                {
+                    uint8_t *ptr    = alloc_aligned<uint8_t>(pData, BLOCK_SIZE * sizeof(float) * 4, DEFAULT_ALIGN);
+                    if (ptr == NULL)
+                        return STATUS_NO_MEM;
+                    for (size_t i=0; i<4; ++i)
+                    {
+                        vBuffers[i]     = reinterpret_cast<float *>(ptr);
+                        ptr            += BLOCK_SIZE * sizeof(float);
+                    }
+
+                    // Create ports
+                    size_t count    = 0;
+                    while (meta->ports[count].id != NULL)
+                        ++count;
+                    vPorts          = static_cast<plug::IPort **>(malloc(count * sizeof(plug::IPort *)));
+                    if (vPorts == NULL)
+                        return STATUS_NO_MEM;
+
+                    size_t audio    = 0;
+                    for (nPorts = 0; nPorts < count; ++nPorts)
+                    {
+                        const meta::port_t *p   = &meta->ports[nPorts];
+                        Port *port              = new Port(p);
+                        if (port == NULL)
+                            return STATUS_NO_MEM;
+                        vPorts[nPorts]          = port;
+                        if ((meta::is_audio_port(p)) && (audio < 4))
+                            vAudio[audio++]         = port;
+                    }
+
+                    // Create the plugin
+                    if ((pPlugin = new plugins::impulse_reverb(meta)) == NULL)
+                        return STATUS_NO_MEM;
+                    if ((pWrapper = new Wrapper(pPlugin, &sExecutor)) == NULL)
+                        return STATUS_NO_MEM;
+
+                    pPlugin->init(pWrapper, vPorts);
+                    pPlugin->set_sample_rate(SAMPLE_RATE);
+                    pPlugin->update_settings();
+                    pPlugin->activate();
+
+                    return STATUS_OK;
+                }
+
+                Port *port(const char *id)
+                {
+                    for (size_t i=0; i<nPorts; ++i)
+                        if (!strcmp(vPorts[i]->metadata()->id, id))
+                            return static_cast<Port *>(vPorts[i]);
+                    return NULL;
+                }
+
+                void set(const char *id, size_t index, float value)
+                {
+                    char name[32];
+                    snprintf(name, sizeof(name), "%s%d", id, int(index));
+                    Port *p         = port(name);
+                    if (p != NULL)
+                        p->set_value(value);
+                }
+
+                void process(size_t samples, bool update)
+                {
+                    for (size_t i=0; i<4; ++i)
+                        if (vAudio[i] != NULL)
+                            vAudio[i]->bind(vBuffers[i]);
+
+                    if (update)
+                        pPlugin->update_settings();
+                    pPlugin->process(samples);
+                    sExecutor.run_tasks();
+                }
+
+                inline bool settled()                       { return pPlugin->settled();    }
+                inline float *buffer(size_t i)              { return vBuffers[i];           }
+        };
+
+        static inline uint32_t next_random(uint32_t *seed)
+        {
+            *seed   = *seed * 1664525 + 1013904223;
+            return *seed >> 8;
+        }
+    } /* namespace rt_stress */
+} /* namespace lsp */
+
+UTEST_BEGIN("impulse_reverb", rt_stress)
+
+    void write_ir(const char *path, size_t channels, size_t length)
+    {
+        // Exponentially decaying noise
+        float *buf      = static_cast<float *>(malloc(length * channels * sizeof(float)));
+        UTEST_ASSERT(buf != NULL);
+        lsp_finally { free(buf); };
+
+        uint32_t seed   = uint32_t(length);
+        const float k   = logf(1e-4f) / length;
+        for (size_t i=0; i<length; ++i)
+            for (size_t j=0; j<channels; ++j)
+                buf[i*channels + j] = expf(k * i) * (float(rt_stress::next_random(&seed) & 0xffff) / 0x8000 - 1.0f);
+
+        mm::audio_stream_t fmt;
+        fmt.srate       = rt_stress::SAMPLE_RATE;
+        fmt.channels    = channels;
+        fmt.frames      = length;
+        fmt.format      = mm::SFMT_F32;
+
+        mm::OutAudioFileStream os;
+        UTEST_ASSERT(os.open(path, &fmt, mm::AFMT_WAV | mm::CFMT_PCM) == STATUS_OK);
+        UTEST_ASSERT(os.write(buf, length) == ssize_t(length));
+        UTEST_ASSERT(os.close() == STATUS_OK);
+    }
+
+    void stress(const char (*files)[PATH_MAX], size_t workers)
+    {
+        rt_stress::Host host;
+        UTEST_ASSERT(host.init(&meta::impulse_reverb_stereo) == STATUS_OK);
+
+        uint32_t seed   = uint32_t(workers) + 1;
+        host.port("wpt")->set_value(workers);
+        host.port("xft")->set_value(1.0f);
+
+        for (size_t step=0; step<rt_stress::STEPS; ++step)
+        {
+            // Change one of the parameters
+            const size_t index  = rt_stress::next_random(&seed) % meta::impulse_reverb_metadata::CONVOLVERS;
+            const uint32_t rnd  = rt_stress::next_random(&seed);
+            switch (rnd % 8)
+            {
+                case 0:
+                {
+                    char name[32];
+                    const size_t file   = (rnd >> 4) % (rt_stress::IR_FILES + 1);
+                    snprintf(name, sizeof(name), "ifn%d", int(index));
+                    host.port(name)->submit((file < rt_stress::IR_FILES) ? files[file] : "");
+                    break;
+                }
+                case 1:
+                    host.port("fft")->set_value((rnd >> 4) % (meta::impulse_reverb_metadata::FFT_RANK_65536 + 1));
+                    break;
+                case 2:
+                    host.set("csf", index, (rnd >> 4) % (meta::impulse_reverb_metadata::FILES + 1));
+                    break;
+                case 3:
+                    host.set("cst", index, (rnd >> 4) % 2);
+                    break;
+                case 4:
+                    host.set("cbm", index, (rnd >> 4) & 1);
+                    break;
+                case 5:
+                    host.set("cmf", index, (rnd >> 4) % (meta::impulse_reverb_metadata::FILES + 1));
+                    host.set("cmx", index, (rnd >> 8) % 101);
+                    break;
+                case 6:
+                    host.set("cam", index, (rnd >> 4) & 1);
+                    break;
+                default:
+                    host.port("lean")->set_value((rnd >> 4) & 1);
+                    break;
+            }
+
+            // Process the block of random size
+            const size_t samples    = 1 + (rt_stress::next_random(&seed) % rt_stress::BLOCK_SIZE);
+            for (size_t i=0; i<2; ++i)
+                for (size_t j=0; j<samples; ++j)
+                    host.buffer(i)[j]   = float(rt_stress::next_random(&seed) & 0xffff) / 0x8000 - 1.0f;
+
+            host.process(samples, true);
+
+            for (size_t i=2; i<4; ++i)
+                for (size_t j=0; j<samples; ++j)
+                    UTEST_ASSERT_MSG(isfinite(host.buffer(i)[j]),
+                        "Non-finite output at step %d, workers=%d", int(step), int(workers));
+        }
+
+        // The plugin should come to the stable state after the changes
+        for (size_t i=0; i<2; ++i)
+            dsp::fill_zero(host.buffer(i), rt_stress::BLOCK_SIZE);
+        size_t blocks = 0;
+        for ( ; (blocks < rt_stress::SETTLE_BLOCKS) && (!host.settled()); ++blocks)
+        {
+            host.process(rt_stress::BLOCK_SIZE, false);
+            if (workers > 0)
+                ipc::Thread::sleep(1);
+        }
+        UTEST_ASSERT_MSG(blocks < rt_stress::SETTLE_BLOCKS, "Plugin has not settled, workers=%d", int(workers));
+    }
+
+    float output_peak(rt_stress::Host *host, size_t samples)
+    {
+        float peak      = 0.0f;
+        for (size_t i=2; i<4; ++i)
+            peak            = lsp_max(peak, dsp::abs_max(host->buffer(i), samples));
+        return peak;
+    }
+
+    void process_noise(rt_stress::Host *host, uint32_t *seed, size_t blocks)
+    {
+        float peak      = 0.0f;
+        for (size_t i=0; i<blocks; ++i)
+        {
+            for (size_t j=0; j<2; ++j)
+                for (size_t k=0; k<rt_stress::BLOCK_SIZE; ++k)
+                    host->buffer(j)[k]  = float(rt_stress::next_random(seed) & 0xffff) / 0x8000 - 1.0f;
+            host->process(rt_stress::BLOCK_SIZE, true);
+            peak            = lsp_max(peak, output_peak(host, rt_stress::BLOCK_SIZE));
+        }
+        UTEST_ASSERT_MSG(peak > rt_stress::SILENCE, "The channel does not produce output");
+    }
+
+    void process_decay(rt_stress::Host *host)
+    {
+        // Let the reverberation tail of the processed signal decay
+        for (size_t i=0; i<2; ++i)
+            dsp::fill_zero(host->buffer(i), rt_stress::BLOCK_SIZE);
+        for (size_t i=0; i<rt_stress::TAIL_BLOCKS; ++i)
+            host->process(rt_stress::BLOCK_SIZE, true);
+    }
+
+    void process_silence(rt_stress::Host *host, const char *stage)
+    {
+        // The output should stay silent both while the convolvers are rebuilt and after that
+        for (size_t i=0; i<2; ++i)
+            dsp::fill_zero(host->buffer(i), rt_stress::BLOCK_SIZE);
+        size_t blocks = 0;
+        for ( ; (blocks < rt_stress::SETTLE_BLOCKS) && ((blocks < rt_stress::TAIL_BLOCKS) || (!host->settled())); ++blocks)
+        {
+            host->process(rt_stress::BLOCK_SIZE, true);
+            const float peak    = output_peak(host, rt_stress::BLOCK_SIZE);
+            UTEST_ASSERT_MSG(peak <= rt_stress::SILENCE,
+                "Stale output level %g after %s at block %d", peak, stage, int(blocks));
+        }
+        UTEST_ASSERT_MSG(blocks < rt_stress::SETTLE_BLOCKS, "Plugin has not settled after %s", stage);
+    }
+
+    void stale_tail(const char (*files)[PATH_MAX])
+    {
+        rt_stress::Host host;
+        UTEST_ASSERT(host.init(&meta::impulse_reverb_stereo) == STATUS_OK);
+
+        // Only the wet signal of the first convolver is passed to the output
+        uint32_t seed   = 1;
+        host.port("dry")->set_value(0.0f);
+        for (size_t i=1; i<meta::impulse_reverb_metadata::CONVOLVERS; ++i)
+            host.set("csf", i, 0.0f);
+        host.port("ifn0")->submit(files[0]);
+        host.port("ifn1")->submit(files[1]);
+        process_silence(&host, "loading");
+
+        // Mute the channel and unmute it in the next block, the tail of the signal should not be played
+        process_noise(&host, &seed, 4);
+        host.set("cam", 0, 1.0f);
+        dsp::fill_zero(host.buffer(0), rt_stress::BLOCK_SIZE);
+        dsp::fill_zero(host.buffer(1), rt_stress::BLOCK_SIZE);
+        host.process(rt_stress::BLOCK_SIZE, true);
+        host.set("cam", 0, 0.0f);
+        process_silence(&host, "unmute");
+        process_noise(&host, &seed, 4);
+        process_decay(&host);
+
+        // Switch the IR bank entry and switch it back
+        host.set("cbm", 0, 1.0f);
+        process_silence(&host, "bank mode");
+        process_noise(&host, &seed, 4);
+        host.set("csf", 0, 2.0f);
+        dsp::fill_zero(host.buffer(0), rt_stress::BLOCK_SIZE);
+        dsp::fill_zero(host.buffer(1), rt_stress::BLOCK_SIZE);
+        host.process(rt_stress::BLOCK_SIZE, true);
+        host.set("csf", 0, 1.0f);
+        process_silence(&host, "bank switch");
+        process_noise(&host, &seed, 4);
+    }
+
+    UTEST_MAIN
+    {
+    #ifndef LSP_IR_RT_CHECK
+        printf("Real-time safety checker is disabled, configure the build with RT_CHECK=1 to enable it\n");
+    #endif /* LSP_IR_RT_CHECK */
+
+        dsp::init();
+        dsp::context_t ctx;
+        dsp::start(&ctx);
+        lsp_finally { dsp::finish(&ctx); };
+
+        // Prepare impulse response files of different length and number of tracks
+        char files[rt_stress::IR_FILES][PATH_MAX];
+        for (size_t i=0; i<rt_stress::IR_FILES; ++i)
+        {
+            snprintf(files[i], PATH_MAX, "%s/utest-%s-%d.wav", tempdir(), full_name(), int(i));
+            write_ir(files[i], i + 1, rt_stress::SAMPLE_RATE * (i + 1) / 4);
+        }
+        lsp_finally {
+            for (size_t i=0; i<rt_stress::IR_FILES; ++i)
+                remove(files[i]);
+        };
+
+        // Run the configurator on the host executor and on the worker pool
+        stress(files, 0);
+        stress(files, 2);
+
+        // Check that convolvers do not play the tail of the signal after they become active again
+        stale_tail(files);
+    }
+
+UTEST_END
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <private/plugins/sample_pool.h>
+
+namespace lsp
+{
+    namespace sample_pool
+    {
+        class Pool: public plugins::SamplePool
+        {
+            public:
+                using plugins::SamplePool::size_class;
+                using plugins::SamplePool::sample_bytes;
+        };
+    } /* namespace sample_pool */
+} /* namespace lsp */
+
+UTEST_BEGIN("impulse_reverb", sample_pool)
+
+    void test_size_class()
+    {
+        typedef sample_pool::Pool P;
+
+        UTEST_ASSERT(P::size_class(0) == 0);
+        UTEST_ASSERT(P::size_class(1) == 0x40);
+        UTEST_ASSERT(P::size_class(0x40) == 0x40);
+        UTEST_ASSERT(P::size_class(0x41) == 0x80);
+        UTEST_ASSERT(P::size_class(0x3ff) == 0x400);
+        UTEST_ASSERT(P::size_class(0x400) == 0x400);
+        UTEST_ASSERT(P::size_class(0x401) == 0x480);
+        UTEST_ASSERT(P::size_class(10000) == 10240);
+
+        // The class covers the length with overhead of at most 12.5% for long samples
+        size_t prev = 0;
+        for (size_t length=1; length < 0x100000; length += (length >> 6) + 1)
+        {
+            const size_t c  = P::size_class(length);
+            UTEST_ASSERT_MSG(c >= length, "length=%d, class=%d", int(length), int(c));
+            UTEST_ASSERT_MSG(c >= prev, "length=%d, class=%d, previous=%d", int(length), int(c), int(prev));
+            UTEST_ASSERT_MSG((c - length) < lsp_max(size_t(0x40), length / 8 + 1), "length=%d, class=%d", int(length), int(c));
+            prev            = c;
+        }
+    }
+
+    void test_recycle()
+    {
+        typedef sample_pool::Pool P;
+        P pool;
+        pool.set_limit(0x1000000);
+
+        // Allocated sample has the capacity of the size class
+        dspu::Sample *a = pool.alloc(2, 1000);
+        UTEST_ASSERT(a != NULL);
+        UTEST_ASSERT(a->channels() == 2);
+        UTEST_ASSERT(a->length() == 1000);
+        UTEST_ASSERT(a->max_length() == P::size_class(1000));
+
+        // Released sample is kept in the pool
+        dspu::Sample *ptr = a;
+        const size_t bytes = P::sample_bytes(a);
+        pool.release(a);
+        UTEST_ASSERT(a == NULL);
+        UTEST_ASSERT(pool.bytes() == bytes);
+
+        // Other number of channels, longer or much shorter samples are not served by the recycled sample
+        dspu::Sample *b = pool.alloc(1, 1000);
+        dspu::Sample *c = pool.alloc(2, 2000);
+        dspu::Sample *d = pool.alloc(2, 100);
+        UTEST_ASSERT((b != NULL) && (c != NULL) && (d != NULL));
+        UTEST_ASSERT((b != ptr) && (c != ptr) && (d != ptr));
+        UTEST_ASSERT(pool.bytes() == bytes);
+
+        // Sample of the same size class is reused
+        a               = pool.alloc(2, 990);
+        UTEST_ASSERT(a == ptr);
+        UTEST_ASSERT(a->length() == 990);
+        UTEST_ASSERT(pool.bytes() == 0);
+
+        const size_t total = P::sample_bytes(a) + P::sample_bytes(b) + P::sample_bytes(c) + P::sample_bytes(d);
+        pool.release(a);
+        pool.release(b);
+        pool.release(c);
+        pool.release(d);
+        UTEST_ASSERT(pool.bytes() == total);
+
+        pool.clear();
+        UTEST_ASSERT(pool.bytes() == 0);
+    }
+
+    void test_limits()
+    {
+        typedef sample_pool::Pool P;
+        P pool;
+
+        // Nothing is kept without limit
+        dspu::Sample *a = pool.alloc(1, 0x400);
+        UTEST_ASSERT(a != NULL);
+        const size_t bytes = P::sample_bytes(a);
+        pool.release(a);
+        UTEST_ASSERT(a == NULL);
+        UTEST_ASSERT(pool.bytes() == 0);
+
+        // The number of recycled samples is limited
+        pool.set_limit(bytes * 0x100);
+        dspu::Sample *vs[0x20];
+        for (size_t i=0; i<0x20; ++i)
+        {
+            vs[i]           = pool.alloc(1, 0x400);
+            UTEST_ASSERT(vs[i] != NULL);
+        }
+        for (size_t i=0; i<0x20; ++i)
+            pool.release(vs[i]);
+        UTEST_ASSERT(pool.bytes() == bytes * 0x10);
+
+        // Lowering the limit evicts the oldest samples
+        pool.set_limit(bytes * 3 + 1);
+        UTEST_ASSERT(pool.bytes() == bytes * 3);
+
+        // Release evicts samples to stay within the limit
+        a               = pool.alloc(1, 0x400);
+        dspu::Sample *b = pool.alloc(1, 0x400);
+        dspu::Sample *c = pool.alloc(1, 0x400);
+        UTEST_ASSERT(pool.bytes() == 0);
+        dspu::Sample *d = pool.alloc(1, 0x400);
+        dspu::Sample *e = pool.alloc(1, 0x400);
+        pool.release(a);
+        pool.release(b);
+        pool.release(c);
+        pool.release(d);
+        pool.release(e);
+        UTEST_ASSERT(pool.bytes() == bytes * 3);
+
+        // Samples above the limit are freed immediately
+        a               = pool.alloc(1, 0x1000);
+        UTEST_ASSERT(a != NULL);
+        pool.release(a);
+        UTEST_ASSERT(pool.bytes() == bytes * 3);
+    }
+
+    UTEST_MAIN
+    {
+        test_size_class();
+        test_recycle();
+        test_limits();
+    }
+
+UTEST_END
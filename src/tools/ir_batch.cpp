@@ -0,0 +1,942 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/meta/impulse_reverb.h>
+#include <private/plugins/impulse_reverb.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/common/atomic.h>
+#include <lsp-plug.in/common/finally.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/dsp-units/units.h>
+#include <lsp-plug.in/ipc/IExecutor.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/mm/InAudioFileStream.h>
+#include <lsp-plug.in/mm/OutAudioFileStream.h>
+#include <lsp-plug.in/plug-fw/meta/func.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Command-line tool which renders audio files through the impulse reverb configured by the plugin's config file:
+//   lsp-ir-batch -c config [-p plugin] [-g gate_db] [-j threads] [-o out_dir] file...
+namespace lsp
+{
+    namespace ir_batch
+    {
+        static constexpr size_t THREADS_MAX     = 64;
+        static constexpr size_t PARAMS_MAX      = 0x200;
+        static constexpr size_t TEXT_MAX        = 0x1000;
+        static constexpr size_t TASKS_MAX       = 0x10;
+        static constexpr size_t BLOCK_SIZE      = 0x10000;  // Number of frames passed to the plugin at once
+        static constexpr size_t SETTLE_BLOCKS   = 0x400;    // Maximum number of blocks to wait for impulse responses
+        static constexpr const char *OUT_SUFFIX = "-reverb.wav";
+
+        typedef struct param_t
+        {
+            char           *sName;          // Identifier of the port
+            char           *sText;          // Value of the path port, NULL for other ports
+            float           fValue;         // Value of the control port
+        } param_t;
+
+        typedef struct config_t
+        {
+            const meta::plugin_t *pMeta;    // Plugin metadata
+            param_t         vParams[PARAMS_MAX];
+            size_t          nParams;        // Number of parameters in the config file
+            float           fGate;          // Tail gate, dB
+            size_t          nThreads;       // Number of worker threads
+            const char     *sConfig;        // Config file
+            const char     *sPlugin;        // Plugin identifier, NULL means the one from the config file
+            const char     *sOutDir;        // Output directory, NULL means the directory of the source file
+            char          **vFiles;         // List of files to process
+            size_t          nFiles;         // Number of files to process
+            volatile uatomic_t nNext;       // Index of the next file to process
+            volatile uatomic_t nErrors;     // Number of failed files
+        } config_t;
+
+        /**
+         * Executor which collects the tasks submitted by the plugin and runs them
+         * between the calls of process(), so loading never races with audio
+         */
+        class Executor: public ipc::IExecutor
+        {
+            private:
+                ipc::ITask     *vTasks[TASKS_MAX];
+                size_t          nTasks;
+
+            public:
+                explicit Executor()
+                {
+                    for (size_t i=0; i<TASKS_MAX; ++i)
+                        vTasks[i]       = NULL;
+                    nTasks          = 0;
+                }
+
+            public:
+                virtual bool submit(ipc::ITask *task) override
+                {
+                    if ((nTasks >= TASKS_MAX) || (!task->idle()))
+                        return false;
+
+                    change_task_state(task, ipc::ITask::TS_SUBMITTED);
+                    vTasks[nTasks++]    = task;
+                    return true;
+                }
+
+                virtual void shutdown() override
+                {
+                    run_tasks();
+                }
+
+                void run_tasks()
+                {
+                    for (size_t i=0; i<nTasks; ++i)
+                    {
+                        run_task(vTasks[i]);
+                        vTasks[i]           = NULL;
+                    }
+                    nTasks          = 0;
+                }
+        };
+
+        class Wrapper: public plug::IWrapper
+        {
+            private:
+                Executor       *pExecutor;
+
+            public:
+                explicit Wrapper(plug::Module *plugin, Executor *executor): plug::IWrapper(plugin, NULL)
+                {
+                    pExecutor       = executor;
+                }
+
+            public:
+                virtual ipc::IExecutor *executor() override     { return pExecutor; }
+        };
+
+        class Path: public plug::path_t
+        {
+            private:
+                enum state_t
+                {
+                    PS_IDLE,
+                    PS_PENDING,
+                    PS_ACCEPTED
+                };
+
+            private:
+                const char     *sPath;
+                size_t          nState;
+
+            public:
+                explicit Path()
+                {
+                    sPath           = "";
+                    nState          = PS_IDLE;
+                }
+
+            public:
+                virtual void init() override                    { nState = PS_IDLE;                 }
+                virtual const char *path() const override       { return sPath;                     }
+                virtual size_t flags() const override           { return 0;                         }
+                virtual void accept() override                  { nState = PS_ACCEPTED;             }
+                virtual void commit() override                  { nState = PS_IDLE;                 }
+                virtual bool pending() override                 { return nState == PS_PENDING;      }
+                virtual bool accepted() override                { return nState == PS_ACCEPTED;     }
+
+                void submit(const char *path)
+                {
+                    sPath           = path;
+                    nState          = PS_PENDING;
+                }
+        };
+
+        class ControlPort: public plug::IPort
+        {
+            private:
+                float           fValue;
+
+            public:
+                explicit ControlPort(const meta::port_t *meta): plug::IPort(meta)
+                {
+                    fValue          = meta->start;
+                }
+
+            public:
+                virtual float value() override                  { return fValue;                    }
+                virtual void set_value(float value) override    { fValue = value;                   }
+        };
+
+        class AudioPort: public plug::IPort
+        {
+            private:
+                float          *pBuffer;
+
+            public:
+                explicit AudioPort(const meta::port_t *meta): plug::IPort(meta)
+                {
+                    pBuffer         = NULL;
+                }
+
+            public:
+                virtual void *buffer() override                 { return pBuffer;                   }
+                inline void bind(float *buf)                    { pBuffer = buf;                    }
+        };
+
+        class PathPort: public plug::IPort
+        {
+            private:
+                Path            sPath;
+
+            public:
+                explicit PathPort(const meta::port_t *meta): plug::IPort(meta) {}
+
+            public:
+                virtual void *buffer() override                 { return &sPath;                    }
+                inline void submit(const char *path)            { sPath.submit(path);               }
+        };
+
+        /**
+         * Offline host of the plugin instance
+         */
+        class Host
+        {
+            private:
+                plugins::impulse_reverb    *pPlugin;
+                Wrapper                    *pWrapper;
+                Executor                    sExecutor;
+                plug::IPort               **vPorts;
+                size_t                      nPorts;
+                AudioPort                  *vIn[2];
+                AudioPort                  *vOut[2];
+                size_t                      nIn;
+                size_t                      nOut;
+                size_t                      nSampleRate;
+                float                      *vBuffers[4];
+                uint8_t                    *pData;
+
+            protected:
+                status_t    create_ports(const config_t *cfg);
+                void        apply_config(const config_t *cfg);
+                status_t    settle();
+
+            public:
+                explicit Host();
+                Host(const Host &) = delete;
+                Host(Host &&) = delete;
+                ~Host();
+
+                Host & operator = (const Host &) = delete;
+                Host & operator = (Host &&) = delete;
+
+                status_t    init(const config_t *cfg, size_t sample_rate);
+                void        destroy();
+
+            public:
+                status_t    set_sample_rate(size_t sample_rate);
+                status_t    reset();
+                void        process(size_t samples);
+
+                inline size_t   inputs() const              { return nIn;           }
+                inline float   *input(size_t i)             { return vBuffers[i];   }
+                inline float   *output(size_t i)            { return vBuffers[i + 2];   }
+                inline size_t   sample_rate() const         { return nSampleRate;   }
+        };
+
+        Host::Host()
+        {
+            pPlugin         = NULL;
+            pWrapper        = NULL;
+            vPorts          = NULL;
+            nPorts          = 0;
+            nIn             = 0;
+            nOut            = 0;
+            nSampleRate     = 0;
+            pData           = NULL;
+            for (size_t i=0; i<2; ++i)
+            {
+                vIn[i]          = NULL;
+                vOut[i]         = NULL;
+            }
+            for (size_t i=0; i<4; ++i)
+                vBuffers[i]     = NULL;
+        }
+
+        Host::~Host()
+        {
+            destroy();
+        }
+
+        status_t Host::create_ports(const config_t *cfg)
+        {
+            const meta::port_t *ports = cfg->pMeta->ports;
+            size_t count    = 0;
+            while (ports[count].id != NULL)
+                ++count;
+
+            vPorts          = static_cast<plug::IPort **>(malloc(count * sizeof(plug::IPort *)));
+            if (vPorts == NULL)
+                return STATUS_NO_MEM;
+
+            for (nPorts = 0; nPorts < count; ++nPorts)
+            {
+                const meta::port_t *p   = &ports[nPorts];
+                plug::IPort *port       = NULL;
+
+                if (meta::is_audio_in_port(p))
+                {
+                    AudioPort *ap           = (nIn < 2) ? new AudioPort(p) : NULL;
+                    if (ap != NULL)
+                        vIn[nIn++]              = ap;
+                    port                    = ap;
+                }
+                else if (meta::is_audio_out_port(p))
+                {
+                    AudioPort *ap           = (nOut < 2) ? new AudioPort(p) : NULL;
+                    if (ap != NULL)
+                        vOut[nOut++]            = ap;
+                    port                    = ap;
+                }
+                else if (meta::is_path_port(p))
+                    port                    = new PathPort(p);
+                else
+                    port                    = new ControlPort(p);
+
+                if (port == NULL)
+                    return STATUS_NO_MEM;
+                vPorts[nPorts]          = port;
+            }
+
+            return (nOut == 2) ? STATUS_OK : STATUS_BAD_STATE;
+        }
+
+        void Host::apply_config(const config_t *cfg)
+        {
+            for (size_t i=0; i<nPorts; ++i)
+            {
+                plug::IPort *port       = vPorts[i];
+                const meta::port_t *p   = port->metadata();
+
+                for (size_t j=0; j<cfg->nParams; ++j)
+                {
+                    const param_t *param    = &cfg->vParams[j];
+                    if (strcmp(param->sName, p->id))
+                        continue;
+
+                    if (meta::is_path_port(p))
+                        static_cast<PathPort *>(port)->submit((param->sText != NULL) ? param->sText : "");
+                    else if (param->sText == NULL)
+                        port->set_value(param->fValue);
+                    break;
+                }
+
+                // Offline rendering with the tool's threads instead of the worker pool
+                if (!strcmp(p->id, "ofl"))
+                    port->set_value(1.0f);
+                else if (!strcmp(p->id, "wpt"))
+                    port->set_value(0.0f);
+            }
+        }
+
+        status_t Host::settle()
+        {
+            for (size_t i=0; i<2; ++i)
+                dsp::fill_zero(vBuffers[i], BLOCK_SIZE);
+
+            // Feed silence until the impulse responses are loaded and applied
+            for (size_t i=0; i<SETTLE_BLOCKS; ++i)
+            {
+                process(BLOCK_SIZE);
+                if (pPlugin->settled())
+                    return STATUS_OK;
+            }
+
+            return STATUS_TIMED_OUT;
+        }
+
+        status_t Host::init(const config_t *cfg, size_t sample_rate)
+        {
+            uint8_t *ptr    = alloc_aligned<uint8_t>(pData, BLOCK_SIZE * sizeof(float) * 4, DEFAULT_ALIGN);
+            if (ptr == NULL)
+                return STATUS_NO_MEM;
+            for (size_t i=0; i<4; ++i)
+            {
+                vBuffers[i]     = reinterpret_cast<float *>(ptr);
+                ptr            += BLOCK_SIZE * sizeof(float);
+            }
+
+            status_t res    = create_ports(cfg);
+            if (res != STATUS_OK)
+                return res;
+            apply_config(cfg);
+
+            // Create the plugin and load the state in the same way as the host does
+            if ((pPlugin = new plugins::impulse_reverb(cfg->pMeta)) == NULL)
+                return STATUS_NO_MEM;
+            if ((pWrapper = new Wrapper(pPlugin, &sExecutor)) == NULL)
+                return STATUS_NO_MEM;
+
+            pPlugin->init(pWrapper, vPorts);
+            nSampleRate     = sample_rate;
+            pPlugin->set_sample_rate(sample_rate);
+            pPlugin->update_settings();
+            pPlugin->state_loaded();
+            pPlugin->activate();
+
+            return settle();
+        }
+
+        void Host::destroy()
+        {
+            if (pPlugin != NULL)
+            {
+                pPlugin->deactivate();
+                sExecutor.run_tasks();
+                pPlugin->destroy();
+                delete pPlugin;
+                pPlugin         = NULL;
+            }
+            if (pWrapper != NULL)
+            {
+                delete pWrapper;
+                pWrapper        = NULL;
+            }
+            if (vPorts != NULL)
+            {
+                for (size_t i=0; i<nPorts; ++i)
+                    delete vPorts[i];
+                free(vPorts);
+                vPorts          = NULL;
+            }
+            free_aligned(pData);
+
+            nPorts          = 0;
+            nIn             = 0;
+            nOut            = 0;
+        }
+
+        status_t Host::set_sample_rate(size_t sample_rate)
+        {
+            if (sample_rate == nSampleRate)
+                return STATUS_OK;
+
+            // The plugin re-renders impulse responses for the new sample rate
+            nSampleRate     = sample_rate;
+            pPlugin->set_sample_rate(sample_rate);
+            pPlugin->update_settings();
+
+            return settle();
+        }
+
+        status_t Host::reset()
+        {
+            // The plugin drops the signal of the previous activation and rebuilds the convolvers
+            pPlugin->deactivate();
+            pPlugin->activate();
+
+            return settle();
+        }
+
+        void Host::process(size_t samples)
+        {
+            for (size_t i=0; i<nIn; ++i)
+                vIn[i]->bind(vBuffers[i]);
+            for (size_t i=0; i<nOut; ++i)
+                vOut[i]->bind(vBuffers[i + 2]);
+
+            pPlugin->process(samples);
+            sExecutor.run_tasks();
+        }
+
+        //---------------------------------------------------------------------
+        static void usage(const char *name)
+        {
+            fprintf(stderr, "Usage: %s -c config [options] file...\n", name);
+            fprintf(stderr, "Renders audio files through the impulse reverb configured by the plugin's config file\n");
+            fprintf(stderr, "Options:\n");
+            fprintf(stderr, "  -c <config>  Configuration file exported by the plugin\n");
+            fprintf(stderr, "  -p <plugin>  Plugin identifier (default is the UID from the config file or %s)\n", meta::impulse_reverb_stereo.uid);
+            fprintf(stderr, "  -g <gate>    Stop rendering the reverb tail below the gate, dB (default -96)\n");
+            fprintf(stderr, "  -j <count>   Number of files processed in parallel (default 1)\n");
+            fprintf(stderr, "  -o <dir>     Output directory (default is the directory of the source file)\n");
+        }
+
+        static char *skip_spaces(char *s)
+        {
+            while ((*s != '\0') && (isspace(uint8_t(*s))))
+                ++s;
+            return s;
+        }
+
+        static const meta::plugin_t *find_plugin(const char *uid)
+        {
+            if (!strcmp(uid, meta::impulse_reverb_mono.uid))
+                return &meta::impulse_reverb_mono;
+            if (!strcmp(uid, meta::impulse_reverb_stereo.uid))
+                return &meta::impulse_reverb_stereo;
+            return NULL;
+        }
+
+        static char *parse_string(char *s)
+        {
+            // Unescape the quoted string in place
+            char *dst   = s;
+            for (++s; (*s != '\0') && (*s != '\"'); ++s)
+            {
+                if ((*s == '\\') && (s[1] != '\0'))
+                    ++s;
+                *(dst++)    = *s;
+            }
+            *dst        = '\0';
+            return (*s == '\"') ? dst : NULL;
+        }
+
+        static char *make_path(const char *config, const char *path)
+        {
+            // Relative paths are resolved against the directory of the config file
+            const char *base    = config;
+            for (const char *p = config; *p != '\0'; ++p)
+                if ((*p == '/') || (*p == '\\'))
+                    base                = p + 1;
+
+            const bool absolute = (path[0] == '\0') || (path[0] == '/') || (path[0] == '\\') || (path[1] == ':');
+            const int dir_len   = (absolute) ? 0 : int(base - config);
+            const size_t len    = dir_len + strlen(path) + 1;
+            char *dst           = static_cast<char *>(malloc(len));
+            if (dst != NULL)
+                snprintf(dst, len, "%.*s%s", dir_len, config, path);
+
+            return dst;
+        }
+
+        static status_t parse_config(config_t *cfg)
+        {
+            FILE *fd        = fopen(cfg->sConfig, "r");
+            if (fd == NULL)
+            {
+                fprintf(stderr, "Could not open config file %s\n", cfg->sConfig);
+                return STATUS_IO_ERROR;
+            }
+            lsp_finally { fclose(fd); };
+
+            char line[TEXT_MAX];
+            char uid[TEXT_MAX];
+            uid[0]          = '\0';
+
+            for (size_t n=1; fgets(line, sizeof(line), fd) != NULL; ++n)
+            {
+                char *s         = skip_spaces(line);
+
+                // The header of the config file contains UID of the plugin
+                if (*s == '#')
+                {
+                    const char *key = strstr(s, "UID:");
+                    if (key != NULL)
+                        sscanf(key + 4, " %4095s", uid);
+                    continue;
+                }
+                if (*s == '\0')
+                    continue;
+
+                // Parse the name of parameter
+                char *name      = s;
+                while ((isalnum(uint8_t(*s))) || (*s == '_'))
+                    ++s;
+                char *tail      = skip_spaces(s);
+                if ((s == name) || (*tail != '=') || (cfg->nParams >= PARAMS_MAX))
+                {
+                    fprintf(stderr, "%s:%d: invalid parameter\n", cfg->sConfig, int(n));
+                    return STATUS_BAD_FORMAT;
+                }
+                *s              = '\0';
+                s               = skip_spaces(tail + 1);
+
+                param_t *p      = &cfg->vParams[cfg->nParams];
+                p->sName        = NULL;
+                p->sText        = NULL;
+                p->fValue       = 0.0f;
+
+                // Parse the value
+                if (*s == '\"')
+                {
+                    if (parse_string(s) == NULL)
+                    {
+                        fprintf(stderr, "%s:%d: unterminated string\n", cfg->sConfig, int(n));
+                        return STATUS_BAD_FORMAT;
+                    }
+                    if ((p->sText = make_path(cfg->sConfig, s)) == NULL)
+                        return STATUS_NO_MEM;
+                }
+                else if (!strncmp(s, "true", 4))
+                    p->fValue       = 1.0f;
+                else if (!strncmp(s, "false", 5))
+                    p->fValue       = 0.0f;
+                else
+                {
+                    char *end       = NULL;
+                    p->fValue       = strtof(s, &end);
+                    if (end == s)
+                    {
+                        fprintf(stderr, "%s:%d: invalid value\n", cfg->sConfig, int(n));
+                        return STATUS_BAD_FORMAT;
+                    }
+
+                    // Gain values are stored in decibels
+                    end             = skip_spaces(end);
+                    if (!strncasecmp(end, "db", 2))
+                        p->fValue       = dspu::db_to_gain(p->fValue);
+                }
+
+                if ((p->sName = strdup(name)) == NULL)
+                {
+                    free(p->sText);
+                    return STATUS_NO_MEM;
+                }
+                ++cfg->nParams;
+            }
+
+            // Select the plugin
+            const char *plugin  = (cfg->sPlugin != NULL) ? cfg->sPlugin :
+                                  (uid[0] != '\0') ? uid : meta::impulse_reverb_stereo.uid;
+            if ((cfg->pMeta = find_plugin(plugin)) == NULL)
+            {
+                fprintf(stderr, "Unsupported plugin %s\n", plugin);
+                return STATUS_NOT_FOUND;
+            }
+
+            return STATUS_OK;
+        }
+
+        static void free_config(config_t *cfg)
+        {
+            for (size_t i=0; i<cfg->nParams; ++i)
+            {
+                free(cfg->vParams[i].sName);
+                free(cfg->vParams[i].sText);
+            }
+            cfg->nParams    = 0;
+        }
+
+        static status_t parse_args(config_t *cfg, int argc, char **argv)
+        {
+            cfg->pMeta          = NULL;
+            cfg->nParams        = 0;
+            cfg->fGate          = -96.0f;
+            cfg->nThreads       = 1;
+            cfg->sConfig        = NULL;
+            cfg->sPlugin        = NULL;
+            cfg->sOutDir        = NULL;
+            cfg->vFiles         = NULL;
+            cfg->nFiles         = 0;
+            cfg->nNext          = 0;
+            cfg->nErrors        = 0;
+
+            int i = 1;
+            for ( ; i < argc; ++i)
+            {
+                const char *arg = argv[i];
+                if (arg[0] != '-')
+                    break;
+                if (!strcmp(arg, "--"))
+                {
+                    ++i;
+                    break;
+                }
+                if ((!strcmp(arg, "-h")) || (!strcmp(arg, "--help")))
+                    return STATUS_CANCELLED;
+                if ((++i) >= argc)
+                {
+                    fprintf(stderr, "Missing value for option %s\n", arg);
+                    return STATUS_BAD_ARGUMENTS;
+                }
+
+                const char *value = argv[i];
+                if (!strcmp(arg, "-c"))
+                    cfg->sConfig        = value;
+                else if (!strcmp(arg, "-p"))
+                    cfg->sPlugin        = value;
+                else if (!strcmp(arg, "-g"))
+                    cfg->fGate          = atof(value);
+                else if (!strcmp(arg, "-j"))
+                    cfg->nThreads       = lsp_limit(atoi(value), 1, int(THREADS_MAX));
+                else if (!strcmp(arg, "-o"))
+                    cfg->sOutDir        = value;
+                else
+                {
+                    fprintf(stderr, "Unknown option %s\n", arg);
+                    return STATUS_BAD_ARGUMENTS;
+                }
+            }
+
+            if (cfg->sConfig == NULL)
+            {
+                fprintf(stderr, "No config file specified\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+            if (cfg->fGate >= 0.0f)
+            {
+                fprintf(stderr, "Invalid option value\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+            if (i >= argc)
+            {
+                fprintf(stderr, "No input files specified\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+
+            cfg->vFiles         = &argv[i];
+            cfg->nFiles         = argc - i;
+
+            return STATUS_OK;
+        }
+
+        static status_t make_output_name(char **dst, const config_t *cfg, const char *src)
+        {
+            // Split the source path into directory, base name and extension
+            const char *base    = src;
+            for (const char *p = src; *p != '\0'; ++p)
+                if ((*p == '/') || (*p == '\\'))
+                    base                = p + 1;
+            const char *ext     = strrchr(base, '.');
+            const int name_len  = (ext != NULL) ? int(ext - base) : int(strlen(base));
+
+            const char *dir     = (cfg->sOutDir != NULL) ? cfg->sOutDir : src;
+            const int dir_len   = (cfg->sOutDir != NULL) ? int(strlen(cfg->sOutDir)) : int(base - src);
+            const char *sep     = ((cfg->sOutDir != NULL) && (dir_len > 0)) ? "/" : "";
+
+            const size_t len    = dir_len + name_len + strlen(OUT_SUFFIX) + 2;
+            char *path          = static_cast<char *>(malloc(len));
+            if (path == NULL)
+                return STATUS_NO_MEM;
+            snprintf(path, len, "%.*s%s%.*s%s", dir_len, dir, sep, name_len, base, OUT_SUFFIX);
+
+            *dst                = path;
+            return STATUS_OK;
+        }
+
+        static status_t write_block(mm::OutAudioFileStream *os, Host *host, float *frame, size_t samples)
+        {
+            // Interleave the output channels
+            const float *l      = host->output(0);
+            const float *r      = host->output(1);
+            for (size_t i=0; i<samples; ++i)
+            {
+                frame[i*2]          = l[i];
+                frame[i*2 + 1]      = r[i];
+            }
+
+            const ssize_t count = os->write(frame, samples);
+            return (count == ssize_t(samples)) ? STATUS_OK : STATUS_IO_ERROR;
+        }
+
+        static float output_peak(Host *host, size_t samples)
+        {
+            return lsp_max(dsp::abs_max(host->output(0), samples), dsp::abs_max(host->output(1), samples));
+        }
+
+        static status_t render_file(const config_t *cfg, Host *host, const char *src)
+        {
+            // Open the source file
+            mm::InAudioFileStream is;
+            mm::audio_stream_t fmt;
+            status_t res = is.open(src);
+            if (res != STATUS_OK)
+                return res;
+            lsp_finally { is.close(); };
+            if ((res = is.info(&fmt)) != STATUS_OK)
+                return res;
+            if (fmt.channels <= 0)
+                return STATUS_BAD_FORMAT;
+
+            if ((res = host->set_sample_rate(fmt.srate)) != STATUS_OK)
+                return res;
+
+            // Open the destination file
+            char *dst = NULL;
+            if ((res = make_output_name(&dst, cfg, src)) != STATUS_OK)
+                return res;
+            lsp_finally { free(dst); };
+
+            mm::audio_stream_t ofmt;
+            ofmt.srate          = fmt.srate;
+            ofmt.channels       = 2;
+            ofmt.frames         = fmt.frames;
+            ofmt.format         = mm::SFMT_F32;
+
+            mm::OutAudioFileStream os;
+            if ((res = os.open(dst, &ofmt, mm::AFMT_WAV | mm::CFMT_PCM)) != STATUS_OK)
+                return res;
+            bool success        = false;
+            lsp_finally {
+                os.close();
+                if (!success)
+                    remove(dst);
+            };
+
+            // Interleaved frames of the source and the destination file
+            const size_t channels   = fmt.channels;
+            float *frame        = static_cast<float *>(malloc(BLOCK_SIZE * lsp_max(channels, size_t(2)) * sizeof(float)));
+            if (frame == NULL)
+                return STATUS_NO_MEM;
+            lsp_finally { free(frame); };
+
+            // Stream the source file through the plugin
+            wsize_t length      = 0;
+            while (true)
+            {
+                const ssize_t count = is.read(frame, BLOCK_SIZE);
+                if (count < 0)
+                {
+                    if (count == -STATUS_EOF)
+                        break;
+                    return status_t(-count);
+                }
+                if (count == 0)
+                    break;
+
+                // Mono files are fed to all inputs
+                for (size_t i=0; i<host->inputs(); ++i)
+                {
+                    float *in           = host->input(i);
+                    const float *s      = &frame[lsp_min(i, channels - 1)];
+                    for (ssize_t j=0; j<count; ++j, s += channels)
+                        in[j]               = *s;
+                }
+
+                host->process(count);
+                if ((res = write_block(&os, host, frame, count)) != STATUS_OK)
+                    return res;
+                length             += count;
+            }
+
+            // Render the reverb tail until it fades below the gate
+            const float gate        = dspu::db_to_gain(cfg->fGate);
+            const size_t tail_max   = dspu::millis_to_samples(fmt.srate,
+                meta::impulse_reverb_metadata::CONV_LENGTH_MAX + meta::impulse_reverb_metadata::PREDELAY_MAX * 2.0f);
+            for (size_t i=0; i<host->inputs(); ++i)
+                dsp::fill_zero(host->input(i), BLOCK_SIZE);
+
+            for (size_t tail = 0; tail < tail_max; tail += BLOCK_SIZE)
+            {
+                host->process(BLOCK_SIZE);
+                if (output_peak(host, BLOCK_SIZE) < gate)
+                    break;
+                if ((res = write_block(&os, host, frame, BLOCK_SIZE)) != STATUS_OK)
+                    return res;
+                length             += BLOCK_SIZE;
+            }
+
+            success             = true;
+            printf("%s -> %s (%d samples)\n", src, dst, int(length));
+
+            // Reset the instance so the remaining tail does not leak into the next file
+            return host->reset();
+        }
+
+        static status_t worker(void *arg)
+        {
+            config_t *cfg = static_cast<config_t *>(arg);
+
+            dsp::context_t ctx;
+            dsp::start(&ctx);
+            lsp_finally { dsp::finish(&ctx); };
+
+            // Each worker hosts its own plugin instance which is created on the first file
+            Host host;
+            bool initialized    = false;
+
+            while (true)
+            {
+                const size_t index  = atomic_add(&cfg->nNext, 1);
+                if (index >= cfg->nFiles)
+                    break;
+
+                const char *src     = cfg->vFiles[index];
+                status_t res        = STATUS_OK;
+                if (!initialized)
+                {
+                    if ((res = host.init(cfg, 48000)) == STATUS_OK)
+                        initialized         = true;
+                    else
+                        host.destroy();
+                }
+                if (res == STATUS_OK)
+                    res                 = render_file(cfg, &host, src);
+
+                if (res != STATUS_OK)
+                {
+                    fprintf(stderr, "Error processing file %s: %s\n", src, get_status(res));
+                    atomic_add(&cfg->nErrors, 1);
+                }
+            }
+
+            return STATUS_OK;
+        }
+
+        int main(int argc, char **argv)
+        {
+            config_t cfg;
+            status_t res = parse_args(&cfg, argc, argv);
+            if (res != STATUS_OK)
+            {
+                usage(argv[0]);
+                return (res == STATUS_CANCELLED) ? 0 : 1;
+            }
+            lsp_finally { free_config(&cfg); };
+
+            if (parse_config(&cfg) != STATUS_OK)
+                return 1;
+
+            dsp::init();
+
+            // Start workers, the main thread also processes files
+            ipc::Thread *threads[THREADS_MAX];
+            const size_t count = lsp_min(cfg.nThreads, cfg.nFiles) - 1;
+            size_t started = 0;
+            for (; started < count; ++started)
+            {
+                threads[started]    = new ipc::Thread(worker, &cfg);
+                if ((threads[started] == NULL) || (threads[started]->start() != STATUS_OK))
+                {
+                    delete threads[started];
+                    break;
+                }
+            }
+
+            worker(&cfg);
+
+            for (size_t i=0; i<started; ++i)
+            {
+                threads[i]->join();
+                delete threads[i];
+            }
+
+            return (cfg.nErrors > 0) ? 1 : 0;
+        }
+    } /* namespace ir_batch */
+} /* namespace lsp */
+
+int main(int argc, char **argv)
+{
+    return lsp::ir_batch::main(argc, argv);
+}
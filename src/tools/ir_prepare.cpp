@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of lsp-plugins-impulse-reverb
+ * Created on: 19 окт. 2026 г.
+ *
+ * lsp-plugins-impulse-reverb is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * lsp-plugins-impulse-reverb is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with lsp-plugins-impulse-reverb. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/meta/impulse_reverb.h>
+#include <private/plugins/prepared_ir.h>
+#include <lsp-plug.in/common/atomic.h>
+#include <lsp-plug.in/common/finally.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/dsp-units/misc/fade.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+#include <lsp-plug.in/dsp-units/units.h>
+#include <lsp-plug.in/ipc/Thread.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Command-line tool which converts audio files into prepared impulse response files:
+//   lsp-ir-prepare [-r sample_rate] [-g gate_db] [-f fade_out_ms] [-j threads] [-o out_dir] file...
+namespace lsp
+{
+    namespace ir_prepare
+    {
+        static constexpr size_t THREADS_MAX     = 64;
+
+        typedef struct config_t
+        {
+            size_t          nSampleRate;    // Target sample rate
+            float           fGate;          // Tail gate, dB, 0 means no trimming
+            float           fFadeOut;       // Fade-out time, ms
+            size_t          nThreads;       // Number of worker threads
+            const char     *sOutDir;        // Output directory, NULL means the directory of the source file
+            char          **vFiles;         // List of files to process
+            size_t          nFiles;         // Number of files to process
+            volatile uatomic_t nNext;       // Index of the next file to process
+            volatile uatomic_t nErrors;     // Number of failed files
+        } config_t;
+
+        static void usage(const char *name)
+        {
+            fprintf(stderr, "Usage: %s [options] file...\n", name);
+            fprintf(stderr, "Converts audio files into prepared impulse response files (*%s)\n", plugins::PREPARED_IR_EXT);
+            fprintf(stderr, "Options:\n");
+            fprintf(stderr, "  -r <srate>   Target sample rate, Hz (default 48000)\n");
+            fprintf(stderr, "  -g <gate>    Drop the tail below the gate relative to the peak, dB (default -96, 0 to disable)\n");
+            fprintf(stderr, "  -f <fade>    Fade-out time at the end of impulse response, ms (default 0)\n");
+            fprintf(stderr, "  -j <count>   Number of files processed in parallel (default 1)\n");
+            fprintf(stderr, "  -o <dir>     Output directory (default is the directory of the source file)\n");
+        }
+
+        static status_t parse_args(config_t *cfg, int argc, char **argv)
+        {
+            cfg->nSampleRate    = 48000;
+            cfg->fGate          = -96.0f;
+            cfg->fFadeOut       = 0.0f;
+            cfg->nThreads       = 1;
+            cfg->sOutDir        = NULL;
+            cfg->vFiles         = NULL;
+            cfg->nFiles         = 0;
+            cfg->nNext          = 0;
+            cfg->nErrors        = 0;
+
+            int i = 1;
+            for ( ; i < argc; ++i)
+            {
+                const char *arg = argv[i];
+                if (arg[0] != '-')
+                    break;
+                if (!strcmp(arg, "--"))
+                {
+                    ++i;
+                    break;
+                }
+                if ((!strcmp(arg, "-h")) || (!strcmp(arg, "--help")))
+                    return STATUS_CANCELLED;
+                if ((++i) >= argc)
+                {
+                    fprintf(stderr, "Missing value for option %s\n", arg);
+                    return STATUS_BAD_ARGUMENTS;
+                }
+
+                const char *value = argv[i];
+                if (!strcmp(arg, "-r"))
+                    cfg->nSampleRate    = atoi(value);
+                else if (!strcmp(arg, "-g"))
+                    cfg->fGate          = atof(value);
+                else if (!strcmp(arg, "-f"))
+                    cfg->fFadeOut       = atof(value);
+                else if (!strcmp(arg, "-j"))
+                    cfg->nThreads       = lsp_limit(atoi(value), 1, int(THREADS_MAX));
+                else if (!strcmp(arg, "-o"))
+                    cfg->sOutDir        = value;
+                else
+                {
+                    fprintf(stderr, "Unknown option %s\n", arg);
+                    return STATUS_BAD_ARGUMENTS;
+                }
+            }
+
+            if ((cfg->nSampleRate <= 0) || (cfg->fGate > 0.0f) || (cfg->fFadeOut < 0.0f))
+            {
+                fprintf(stderr, "Invalid option value\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+            if (i >= argc)
+            {
+                fprintf(stderr, "No input files specified\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+
+            cfg->vFiles         = &argv[i];
+            cfg->nFiles         = argc - i;
+
+            return STATUS_OK;
+        }
+
+        static status_t make_output_name(char **dst, const config_t *cfg, const char *src)
+        {
+            // Split the source path into directory, base name and extension
+            const char *base    = src;
+            for (const char *p = src; *p != '\0'; ++p)
+                if ((*p == '/') || (*p == '\\'))
+                    base                = p + 1;
+            const char *ext     = strrchr(base, '.');
+            const int name_len  = (ext != NULL) ? int(ext - base) : int(strlen(base));
+
+            const char *dir     = (cfg->sOutDir != NULL) ? cfg->sOutDir : src;
+            const int dir_len   = (cfg->sOutDir != NULL) ? int(strlen(cfg->sOutDir)) : int(base - src);
+            const char *sep     = ((cfg->sOutDir != NULL) && (dir_len > 0)) ? "/" : "";
+
+            const size_t len    = dir_len + name_len + strlen(plugins::PREPARED_IR_EXT) + 2;
+            char *path          = static_cast<char *>(malloc(len));
+            if (path == NULL)
+                return STATUS_NO_MEM;
+            snprintf(path, len, "%.*s%s%.*s%s", dir_len, dir, sep, name_len, base, plugins::PREPARED_IR_EXT);
+
+            *dst                = path;
+            return STATUS_OK;
+        }
+
+        static status_t write_file(const char *path, const config_t *cfg, dspu::Sample *s, size_t length, float peak)
+        {
+            FILE *fd        = fopen(path, "wb");
+            if (fd == NULL)
+                return STATUS_IO_ERROR;
+            bool success    = false;
+            lsp_finally {
+                fclose(fd);
+                if (!success)
+                    remove(path);
+            };
+
+            plugins::prepared_ir_header_t hdr;
+            memcpy(hdr.vSignature, "LIRP", 4);
+            hdr.nVersion        = CPU_TO_LE(plugins::PREPARED_IR_VERSION);
+            hdr.nHeaderSize     = CPU_TO_LE(uint32_t(sizeof(hdr)));
+            hdr.nChannels       = CPU_TO_LE(uint32_t(s->channels()));
+            hdr.nLength         = CPU_TO_LE(uint32_t(length));
+            hdr.nSampleRate     = CPU_TO_LE(uint32_t(s->sample_rate()));
+            hdr.fPeak           = CPU_TO_LE(peak);
+            hdr.fGate           = CPU_TO_LE(cfg->fGate);
+            hdr.fFadeOut        = CPU_TO_LE(cfg->fFadeOut);
+
+            if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1)
+                return STATUS_IO_ERROR;
+
+            for (size_t i=0; i<s->channels(); ++i)
+            {
+                float *data         = s->channel(i);
+            #ifdef ARCH_BE
+                for (size_t j=0; j<length; ++j)
+                    data[j]             = CPU_TO_LE(data[j]);
+            #endif /* ARCH_BE */
+                if (fwrite(data, sizeof(float), length, fd) != length)
+                    return STATUS_IO_ERROR;
+            }
+
+            success         = true;
+            return STATUS_OK;
+        }
+
+        static status_t prepare_file(const config_t *cfg, const char *src)
+        {
+            // Load the file
+            dspu::Sample s;
+            status_t res = s.load(src, meta::impulse_reverb_metadata::CONV_LENGTH_MAX * 0.001f);
+            if (res != STATUS_OK)
+                return res;
+
+            // Determine the peak of the original data the same way the plugin does it for the source file
+            const size_t channels   = s.channels();
+            float peak              = 0.0f;
+            for (size_t i=0; i<channels; ++i)
+                peak                    = lsp_max(peak, dsp::abs_max(s.channel(i), s.length()));
+
+            // Resample the file
+            if (s.sample_rate() != cfg->nSampleRate)
+            {
+                if ((res = s.resample(cfg->nSampleRate)) != STATUS_OK)
+                    return res;
+            }
+
+            // Determine the length of the tail which is above the gate
+            size_t length           = s.length();
+
+            if ((cfg->fGate < 0.0f) && (peak > 0.0f))
+            {
+                const float threshold   = peak * dspu::db_to_gain(cfg->fGate);
+                size_t tail             = 1;
+                for (size_t i=0; i<channels; ++i)
+                {
+                    const float *data       = s.channel(i);
+                    for (size_t j=length; j > tail; --j)
+                        if (fabsf(data[j-1]) > threshold)
+                        {
+                            tail                    = j;
+                            break;
+                        }
+                }
+                length                  = tail;
+            }
+
+            // Apply fade-out
+            const size_t fade       = dspu::millis_to_samples(cfg->nSampleRate, cfg->fFadeOut);
+            for (size_t i=0; i<channels; ++i)
+                dspu::fade_out(s.channel(i), s.channel(i), fade, length);
+
+            // Write the result
+            char *dst = NULL;
+            if ((res = make_output_name(&dst, cfg, src)) != STATUS_OK)
+                return res;
+            lsp_finally { free(dst); };
+
+            if ((res = write_file(dst, cfg, &s, length, peak)) != STATUS_OK)
+                return res;
+
+            printf("%s -> %s (%d tracks, %d samples)\n", src, dst, int(channels), int(length));
+            return STATUS_OK;
+        }
+
+        static status_t worker(void *arg)
+        {
+            config_t *cfg = static_cast<config_t *>(arg);
+
+            dsp::context_t ctx;
+            dsp::start(&ctx);
+            lsp_finally { dsp::finish(&ctx); };
+
+            // Take files one by one until the list is exhausted
+            while (true)
+            {
+                const size_t index  = atomic_add(&cfg->nNext, 1);
+                if (index >= cfg->nFiles)
+                    break;
+
+                const char *src     = cfg->vFiles[index];
+                const status_t res  = prepare_file(cfg, src);
+                if (res != STATUS_OK)
+                {
+                    fprintf(stderr, "Error processing file %s: %s\n", src, get_status(res));
+                    atomic_add(&cfg->nErrors, 1);
+                }
+            }
+
+            return STATUS_OK;
+        }
+
+        int main(int argc, char **argv)
+        {
+            config_t cfg;
+            status_t res = parse_args(&cfg, argc, argv);
+            if (res != STATUS_OK)
+            {
+                usage(argv[0]);
+                return (res == STATUS_CANCELLED) ? 0 : 1;
+            }
+
+            dsp::init();
+
+            // Start workers, the main thread also processes files
+            ipc::Thread *threads[THREADS_MAX];
+            const size_t count = lsp_min(cfg.nThreads, cfg.nFiles) - 1;
+            size_t started = 0;
+            for (; started < count; ++started)
+            {
+                threads[started]    = new ipc::Thread(worker, &cfg);
+                if ((threads[started] == NULL) || (threads[started]->start() != STATUS_OK))
+                {
+                    delete threads[started];
+                    break;
+                }
+            }
+
+            worker(&cfg);
+
+            for (size_t i=0; i<started; ++i)
+            {
+                threads[i]->join();
+                delete threads[i];
+            }
+
+            return (cfg.nErrors > 0) ? 1 : 0;
+        }
+    } /* namespace ir_prepare */
+} /* namespace lsp */
+
+int main(int argc, char **argv)
+{
+    return lsp::ir_prepare::main(argc, argv);
+}